@@ -0,0 +1,407 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file
+ * @brief
+ *   TySettings benchmark: throughput and latency of the settings API, written to stdout as JSON.
+ */
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <ty/instance.h>
+#include <ty/logging.h>
+#include "tysettings/platform/settings.h"
+
+static const char *kLogModule = "Benchmark";
+
+namespace {
+
+constexpr uint16_t kProbeKey     = 0;     ///< The key written by the measured operations, never part of the store.
+constexpr uint32_t kMaxStoreKeys = 40000; ///< Larger stores hold several values per key.
+constexpr uint64_t kBudgetNs     = 300 * 1000 * 1000ull;
+constexpr size_t   kMinSamples   = 3;
+constexpr size_t   kMaxSamples   = 1000;
+constexpr uint16_t kBulkLength   = 4000;
+
+/**
+ * Describes the settings store an operation is measured on.
+ */
+struct Case
+{
+    const char *mSweep;
+    uint32_t    mRecords;   ///< The number of records in the store besides the probe key.
+    uint16_t    mValueSize; ///< The size of the values written and read by the measured operations.
+    uint16_t    mFanout;    ///< The number of values of the probe key.
+    const char *mAccess;    ///< "hot" reads the same key over and over, "cold" a random key of the store.
+    size_t      mStoreBytes;
+};
+
+tinyInstance *sInstance;
+bool          sFirstResult = true;
+uint32_t      sRandom      = 0x12345678;
+uint8_t       sValue[UINT16_MAX];
+
+uint64_t GetNowNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+}
+
+uint32_t GetRandom(void)
+{
+    sRandom ^= sRandom << 13;
+    sRandom ^= sRandom >> 17;
+    sRandom ^= sRandom << 5;
+
+    return sRandom;
+}
+
+uint16_t GetStoreKey(uint32_t aRecord)
+{
+    return static_cast<uint16_t>(1 + aRecord % kMaxStoreKeys);
+}
+
+/**
+ * Wipes the store and fills it with @p aRecords values of @p aValueSize bytes, in a single batch if supported.
+ */
+void FillStore(uint32_t aRecords, uint16_t aValueSize)
+{
+    bool batch;
+
+    tyPlatSettingsWipe(sInstance);
+    batch = (tyPlatSettingsBeginBatch(sInstance) == TY_ERROR_NONE);
+
+    for (uint32_t i = 0; i < aRecords; i++)
+    {
+        tyPlatSettingsAdd(sInstance, GetStoreKey(i), sValue, aValueSize);
+    }
+
+    if (batch)
+    {
+        tyPlatSettingsCommitBatch(sInstance);
+    }
+}
+
+void FillProbe(uint16_t aFanout, uint16_t aValueSize)
+{
+    tyPlatSettingsDelete(sInstance, kProbeKey, -1);
+
+    for (uint16_t i = 0; i < aFanout; i++)
+    {
+        tyPlatSettingsAdd(sInstance, kProbeKey, sValue, aValueSize);
+    }
+}
+
+/**
+ * Gets the number of bytes written to the store so far, or -1 if the platform keeps no statistics.
+ */
+int64_t GetBytesWritten(void)
+{
+    tyPlatSettingsStats stats;
+
+    return (tyPlatSettingsGetStats(sInstance, &stats) == TY_ERROR_NONE) ? static_cast<int64_t>(stats.mBytesWritten)
+                                                                        : -1;
+}
+
+void Report(const Case            &aCase,
+            const char            *aOperation,
+            std::vector<uint64_t> &aSamples,
+            uint64_t               aTotalNs,
+            int64_t                aBytesWritten)
+{
+    uint64_t sum = 0;
+
+    std::sort(aSamples.begin(), aSamples.end());
+
+    for (uint64_t sample : aSamples)
+    {
+        sum += sample;
+    }
+
+    printf("%s\n    {\"sweep\": \"%s\", \"op\": \"%s\", \"records\": %" PRIu32 ", \"value_size\": %u, \"fanout\": %u, "
+           "\"access\": \"%s\", \"store_bytes\": %zu, \"samples\": %zu, \"ops_per_sec\": %.1f, \"mean_ns\": %" PRIu64
+           ", \"p50_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64,
+           sFirstResult ? "" : ",", aCase.mSweep, aOperation, aCase.mRecords, aCase.mValueSize, aCase.mFanout,
+           aCase.mAccess, aCase.mStoreBytes, aSamples.size(),
+           aTotalNs == 0 ? 0.0 : static_cast<double>(aSamples.size()) * 1e9 / static_cast<double>(aTotalNs),
+           sum / aSamples.size(), aSamples[(aSamples.size() - 1) / 2], aSamples[(aSamples.size() - 1) * 99 / 100]);
+
+    if (aBytesWritten >= 0)
+    {
+        printf(", \"bytes_written_per_op\": %.1f",
+               static_cast<double>(aBytesWritten) / static_cast<double>(aSamples.size()));
+    }
+
+    printf("}");
+    fflush(stdout);
+
+    sFirstResult = false;
+}
+
+/**
+ * Measures @p aOperation until the time budget or the maximum number of samples is reached.
+ *
+ * @p aPrepare runs before every sample and is not measured. The bytes written are only counted if @p aCountBytes is
+ * set, the store may not be initialized between @p aPrepare and @p aMeasured.
+ */
+template <typename Prepare, typename Operation>
+void Measure(const Case &aCase,
+             const char *aOperation,
+             Prepare     aPrepare,
+             Operation   aMeasured,
+             size_t      aMaxSamples,
+             bool        aCountBytes = false)
+{
+    std::vector<uint64_t> samples;
+    uint64_t              total   = 0;
+    int64_t               written = aCountBytes ? 0 : -1;
+
+    fprintf(stderr, "%s %s records=%" PRIu32 " value_size=%u fanout=%u access=%s\n", aCase.mSweep, aOperation,
+            aCase.mRecords, aCase.mValueSize, aCase.mFanout, aCase.mAccess);
+
+    while (samples.size() < aMaxSamples && (samples.size() < kMinSamples || total < kBudgetNs))
+    {
+        uint64_t start;
+
+        int64_t before;
+
+        aPrepare();
+        before = (written >= 0) ? GetBytesWritten() : -1;
+        start  = GetNowNs();
+        aMeasured();
+        samples.push_back(GetNowNs() - start);
+        total += samples.back();
+        written = (before >= 0) ? written + GetBytesWritten() - before : -1;
+    }
+
+    Report(aCase, aOperation, samples, total, written);
+}
+
+template <typename Operation> void Measure(const Case &aCase, const char *aOperation, Operation aMeasured)
+{
+    Measure(aCase, aOperation, []() {}, aMeasured, kMaxSamples, true);
+}
+
+/**
+ * Measures all operations on the store of @p aCase, which is filled with values of @p aStoreValueSize bytes.
+ */
+void RunCase(const Case &aCase, uint16_t aStoreValueSize, bool aWithWipe)
+{
+    uint8_t  value[UINT16_MAX];
+    uint16_t fanout = aCase.mFanout;
+
+    FillStore(aCase.mRecords, aStoreValueSize);
+    FillProbe(fanout, aCase.mValueSize);
+
+    Measure(aCase, "get", [&]() {
+        uint16_t length = sizeof(value);
+
+        if (strcmp(aCase.mAccess, "hot") == 0 || aCase.mRecords == 0)
+        {
+            tyPlatSettingsGet(sInstance, kProbeKey, fanout - 1, value, &length);
+        }
+        else
+        {
+            uint32_t record = GetRandom() % aCase.mRecords;
+
+            tyPlatSettingsGet(sInstance, GetStoreKey(record), static_cast<int>(record / kMaxStoreKeys), value,
+                              &length);
+        }
+    });
+
+    // Writes always go to the probe key, the access pattern only applies to reads.
+    if (strcmp(aCase.mAccess, "hot") == 0)
+    {
+        Measure(aCase, "add", [&]() { tyPlatSettingsAdd(sInstance, kProbeKey, sValue, aCase.mValueSize); });
+        FillProbe(fanout, aCase.mValueSize);
+
+        // Deletes the value added before each sample, the store keeps its size.
+        Measure(
+            aCase, "delete", [&]() { tyPlatSettingsAdd(sInstance, kProbeKey, sValue, aCase.mValueSize); },
+            [&]() { tyPlatSettingsDelete(sInstance, kProbeKey, fanout); }, kMaxSamples);
+        FillProbe(fanout, aCase.mValueSize);
+
+        if (fanout == 1)
+        {
+            Measure(aCase, "set", [&]() { tyPlatSettingsSet(sInstance, kProbeKey, sValue, aCase.mValueSize); });
+        }
+    }
+
+    if (aWithWipe)
+    {
+        Measure(
+            aCase, "wipe",
+            [&]() {
+                FillStore(aCase.mRecords, aStoreValueSize);
+                FillProbe(fanout, aCase.mValueSize);
+            },
+            []() { tyPlatSettingsWipe(sInstance); }, kMinSamples);
+    }
+
+    tyPlatSettingsFlush(sInstance);
+}
+
+void RunStoreSizeSweep(void)
+{
+    for (uint32_t records : {10u, 100u, 1000u, 10000u, 100000u})
+    {
+        for (const char *access : {"hot", "cold"})
+        {
+            Case storeCase = {"store_size", records, 16, 1, access, records * 16u};
+
+            RunCase(storeCase, 16, access[0] == 'c');
+        }
+    }
+}
+
+void RunValueSizeSweep(void)
+{
+    for (uint16_t valueSize : {0, 16, 256, 4096, UINT16_MAX})
+    {
+        Case valueCase = {"value_size", 100, valueSize, 1, "hot", 100u * 16};
+
+        RunCase(valueCase, 16, false);
+    }
+}
+
+void RunFanoutSweep(void)
+{
+    for (uint16_t fanout : {1, 10, 100, 1000})
+    {
+        Case fanoutCase = {"fanout", 100, 16, fanout, "hot", 100u * 16};
+
+        RunCase(fanoutCase, 16, false);
+    }
+}
+
+/**
+ * Writes and reads structured values, which compress well, and random values, which do not.
+ *
+ * Built with `TYSETTINGS_CONFIG_COMPRESS_THRESHOLD` set, the bytes written show the I/O saved and the latencies the
+ * CPU spent for it.
+ */
+void RunCompressionSweep(void)
+{
+    static uint8_t content[4096];
+
+    for (const char *sweep : {"compression_tlv", "compression_random"})
+    {
+        bool random = (strcmp(sweep, "compression_random") == 0);
+
+        for (size_t i = 0; i < sizeof(content); i += 8)
+        {
+            // TLVs of a type, a length and a small counter, as stored by network stacks.
+            const uint8_t tlv[8] = {static_cast<uint8_t>(i / 8 % 5), 6, static_cast<uint8_t>(i / 8), 0, 0, 0, 0, 0};
+
+            memcpy(&content[i], tlv, sizeof(tlv));
+        }
+
+        for (size_t i = 0; random && i < sizeof(content); i++)
+        {
+            content[i] = static_cast<uint8_t>(GetRandom());
+        }
+
+        for (uint16_t valueSize : {64, 256, 4096})
+        {
+            Case    compressionCase = {sweep, 100, valueSize, 1, "hot", 100u * 16};
+            uint8_t value[sizeof(content)];
+
+            FillStore(compressionCase.mRecords, 16);
+
+            Measure(compressionCase, "set",
+                    [&]() { tyPlatSettingsSet(sInstance, kProbeKey, content, compressionCase.mValueSize); });
+
+            Measure(compressionCase, "get", [&]() {
+                uint16_t length = sizeof(value);
+
+                tyPlatSettingsGet(sInstance, kProbeKey, 0, value, &length);
+            });
+
+            tyPlatSettingsFlush(sInstance);
+        }
+    }
+}
+
+/**
+ * Grows the store to several megabytes, measuring a small set and loading the store at every step.
+ */
+void RunLargeStoreSweep(void)
+{
+    uint32_t records = 0;
+
+    tyPlatSettingsWipe(sInstance);
+
+    for (size_t size : {64 * 1024, 1024 * 1024, 4 * 1024 * 1024, 8 * 1024 * 1024})
+    {
+        bool batch = (tyPlatSettingsBeginBatch(sInstance) == TY_ERROR_NONE);
+        Case largeCase;
+
+        for (; records * static_cast<size_t>(kBulkLength) < size; records++)
+        {
+            tyPlatSettingsAdd(sInstance, GetStoreKey(records), sValue, kBulkLength);
+        }
+
+        if (batch)
+        {
+            tyPlatSettingsCommitBatch(sInstance);
+        }
+
+        largeCase = {"large_store", records, 4, 1, "hot", records * static_cast<size_t>(kBulkLength)};
+
+        Measure(largeCase, "set", [&]() { tyPlatSettingsSet(sInstance, kProbeKey, sValue, largeCase.mValueSize); });
+
+        // Only the submission is measured, the change is written by the platform in the background.
+        if (tyPlatSettingsGetEventFd(sInstance) >= 0)
+        {
+            Measure(largeCase, "set_async", [&]() {
+                tyPlatSettingsSetAsync(sInstance, kProbeKey, sValue, largeCase.mValueSize, nullptr, nullptr);
+            });
+        }
+
+        tyPlatSettingsFlush(sInstance);
+        tyPlatSettingsProcess(sInstance);
+
+        // Loading validates every record of the store.
+        Measure(
+            largeCase, "init", []() { tyPlatSettingsDeinit(sInstance); },
+            []() { tyPlatSettingsInit(sInstance, NULL, 0); }, 20);
+    }
+}
+
+} // namespace
+
+extern "C" int main(void)
+{
+    tyLogInfo(kLogModule, "Starting TySettings benchmark");
+    sInstance = tinyInstanceInitSingle();
+    tyPlatSettingsInit(sInstance, NULL, 0);
+
+    for (size_t i = 0; i < sizeof(sValue); i++)
+    {
+        sValue[i] = static_cast<uint8_t>(i);
+    }
+
+    printf("{\n  \"benchmark\": \"tysettings\",\n  \"results\": [");
+
+    RunStoreSizeSweep();
+    RunValueSizeSweep();
+    RunFanoutSweep();
+    RunCompressionSweep();
+    RunLargeStoreSweep();
+
+    printf("\n  ]\n}\n");
+
+    tyPlatSettingsWipe(sInstance);
+    tyPlatSettingsDeinit(sInstance);
+    tinyInstanceFinalize(sInstance);
+
+    return 0;
+}
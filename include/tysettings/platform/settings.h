@@ -10,6 +10,9 @@
 #ifndef TYSETTINGS_SETTINGS_H
 #define TYSETTINGS_SETTINGS_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include <ty/instance.h>
 
 #ifdef __cplusplus
@@ -34,6 +37,26 @@ enum
     TY_SETTINGS_KEY_VENDOR_RESERVED_MAX = 0xffff,
 };
 
+/**
+ * Sets the name the settings store of an instance is persisted under.
+ *
+ * Each instance has its own settings store. Instances with different names run in parallel without sharing any
+ * state. The name applies from the next `tyPlatSettingsInit()` until `tyPlatSettingsDeinit()`. Without a name the
+ * platform chooses a default one, which is the same for all instances.
+ *
+ * On the POSIX platform the name is the base name of the settings file.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ * @param[in]  aBaseName  A pointer to the null-terminated name. The string is copied.
+ *
+ * @retval TY_ERROR_NONE             The name is used by the next `tyPlatSettingsInit()`.
+ * @retval TY_ERROR_INVALID_ARGS     The name is empty, too long or not a valid name on this platform.
+ * @retval TY_ERROR_INVALID_STATE    The settings store of @p aInstance is initialized already.
+ * @retval TY_ERROR_NO_BUFS          The maximum number of instances is reached.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsSetBaseName(tinyInstance *aInstance, const char *aBaseName);
+
 /**
  * Performs any initialization for the settings subsystem, if necessary.
  *
@@ -95,6 +118,169 @@ tinyError tyPlatSettingsGet(tinyInstance *aInstance,
                             uint8_t      *aValue,
                             uint16_t     *aValueLength);
 
+/**
+ * Describes a setting to fetch with `tyPlatSettingsGetMany()`.
+ */
+typedef struct tyPlatSettingsRequest
+{
+    uint16_t   mKey;         ///< The key associated with the requested setting.
+    int        mIndex;       ///< The index of the specific item to get.
+    uint8_t   *mValue;       ///< Where the value is written, may be NULL like @p aValue of `tyPlatSettingsGet()`.
+    uint16_t  *mValueLength; ///< The size of `mValue` on input, the length of the setting on output. May be NULL.
+    tinyError *mError;       ///< Where the result of the request is written. May be NULL.
+} tyPlatSettingsRequest;
+
+/**
+ * Fetches the values of several settings at once.
+ *
+ * Behaves like calling `tyPlatSettingsGet()` for every request, but resolves all requests with a single pass over the
+ * setting store. The result of every request, TY_ERROR_NONE or TY_ERROR_NOT_FOUND, is written to its `mError`.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ * @param[in]  aRequests  A pointer to an array of requests.
+ * @param[in]  aCount     The number of requests in @p aRequests.
+ *
+ * @retval TY_ERROR_NONE             All requested settings were found and fetched successfully.
+ * @retval TY_ERROR_NOT_FOUND        At least one requested setting was not found in the setting store.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsGetMany(tinyInstance *aInstance, const tyPlatSettingsRequest *aRequests, size_t aCount);
+
+/**
+ * Holds the position of an iteration over the values of a setting, or of the whole setting store.
+ *
+ * All fields except `mKey` are platform state and must not be used by the caller.
+ */
+typedef struct tyPlatSettingsIter
+{
+    int32_t  mKey;       ///< The key whose values are iterated, or -1 if the whole setting store is iterated.
+    uint16_t mNextKey;   ///< The key of the next value.
+    int      mNextIndex; ///< The index of the next value within its key.
+    uint32_t mPosition;  ///< A platform specific position within the setting store.
+    void    *mContext;   ///< A platform specific pointer, e.g. to an iterator of the storage.
+} tyPlatSettingsIter;
+
+/**
+ * Starts an iteration over the values of a setting, or of the whole setting store.
+ *
+ * Every value is returned once by `tyPlatSettingsIterNext()`, which continues where the previous call stopped instead
+ * of searching the value by its index like `tyPlatSettingsGet()`. The values of a key are returned in the order of
+ * their indexes, the keys in no particular order. Values written to the store while iterating may or may not be
+ * returned, and values may be skipped if values of the same key are deleted while iterating. Settings with sensitive
+ * keys are only returned when iterating their key.
+ *
+ * Every iteration started successfully must be ended with `tyPlatSettingsIterEnd()`.
+ *
+ * On Zephyr, every call of `tyPlatSettingsIterNext()` starts a new pass over the settings which passes all values
+ * returned before, iterating N values costs O(N^2). Use `tyPlatSettingsForEach()` there to read many values.
+ *
+ * @param[in]   aInstance  The OpenThread instance structure.
+ * @param[out]  aIter      A pointer to the iteration to start.
+ * @param[in]   aKey       The key whose values to iterate, or -1 to iterate all values of the setting store.
+ *
+ * @retval TY_ERROR_NONE             The iteration was started.
+ * @retval TY_ERROR_INVALID_ARGS     @p aKey is neither a key nor -1.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsIterBegin(tinyInstance *aInstance, tyPlatSettingsIter *aIter, int32_t aKey);
+
+/**
+ * Fetches the next value of an iteration.
+ *
+ * @p aValue and @p aValueLength are used like with `tyPlatSettingsGet()`.
+ *
+ * @param[in]      aInstance     The OpenThread instance structure.
+ * @param[in,out]  aIter         A pointer to the iteration.
+ * @param[out]     aKey          A pointer to where the key of the value should be written. May be NULL.
+ * @param[out]     aValue        A pointer to where the value should be written. May be NULL.
+ * @param[in,out]  aValueLength  A pointer to the length of the value. May be NULL.
+ *
+ * @retval TY_ERROR_NONE       The next value was fetched successfully.
+ * @retval TY_ERROR_NOT_FOUND  All values have been returned.
+ */
+tinyError tyPlatSettingsIterNext(tinyInstance       *aInstance,
+                                 tyPlatSettingsIter *aIter,
+                                 uint16_t           *aKey,
+                                 uint8_t            *aValue,
+                                 uint16_t           *aValueLength);
+
+/**
+ * Ends an iteration and releases its resources.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ * @param[in]  aIter      A pointer to the iteration to end.
+ */
+void tyPlatSettingsIterEnd(tinyInstance *aInstance, tyPlatSettingsIter *aIter);
+
+/**
+ * Is called by `tyPlatSettingsForEach()` for every value.
+ *
+ * @param[in]  aInstance     The OpenThread instance structure.
+ * @param[in]  aKey          The key of the value.
+ * @param[in]  aValue        A pointer to the value, only valid during the call.
+ * @param[in]  aValueLength  The length of the value.
+ * @param[in]  aContext      The pointer passed to `tyPlatSettingsForEach()`.
+ *
+ * @retval TRUE   Continue with the next value.
+ * @retval FALSE  Stop the walk.
+ */
+typedef bool (*tyPlatSettingsForEachCallback)(tinyInstance  *aInstance,
+                                              uint16_t       aKey,
+                                              const uint8_t *aValue,
+                                              uint16_t       aValueLength,
+                                              void          *aContext);
+
+/**
+ * Calls a function for every value of a setting, or of the whole setting store.
+ *
+ * The values are passed in the order of `tyPlatSettingsIterNext()`, the values of a key in the order of their indexes.
+ * Unlike the iteration, the walk makes a single pass over the setting store, which is the cheapest way to read many
+ * values on platforms which cannot resume a pass. @p aCallback must not change the setting store.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ * @param[in]  aKey       The key whose values to walk, or -1 to walk all values of the setting store.
+ * @param[in]  aCallback  The function to call for every value.
+ * @param[in]  aContext   A pointer passed to @p aCallback.
+ *
+ * @retval TY_ERROR_NONE             All values were passed, or @p aCallback stopped the walk.
+ * @retval TY_ERROR_INVALID_ARGS     @p aKey is neither a key nor -1.
+ * @retval TY_ERROR_NO_BUFS          A value could not be buffered.
+ * @retval TY_ERROR_FAILED           A value could not be read.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsForEach(tinyInstance                 *aInstance,
+                                int32_t                       aKey,
+                                tyPlatSettingsForEachCallback aCallback,
+                                void                         *aContext);
+
+/**
+ * Fetches the value of a setting without copying it.
+ *
+ * Looks up the setting identified by @p aKey and @p aIndex like `tyPlatSettingsGet()`, but instead of copying the
+ * value it returns a pointer to the value within the storage of the platform layer. Large values can thereby be
+ * parsed in place.
+ *
+ * The returned pointer is read-only and remains valid until the next write operation on the settings store
+ * (`tyPlatSettingsSet()`, `tyPlatSettingsAdd()`, `tyPlatSettingsDelete()` or `tyPlatSettingsWipe()`) or until
+ * `tyPlatSettingsDeinit()` is called.
+ *
+ * @param[in]   aInstance  The OpenThread instance structure.
+ * @param[in]   aKey       The key associated with the requested setting.
+ * @param[in]   aIndex     The index of the specific item to get.
+ * @param[out]  aData      A pointer to where the pointer to the value should be written. MUST NOT be NULL.
+ * @param[out]  aLength    A pointer to where the length of the value should be written. MUST NOT be NULL.
+ *
+ * @retval TY_ERROR_NONE             The given setting was found and @p aData points to its value.
+ * @retval TY_ERROR_NOT_FOUND        The given setting was not found in the setting store.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform or the value is stored
+ *                                   compressed.
+ */
+tinyError tyPlatSettingsGetView(tinyInstance   *aInstance,
+                                uint16_t        aKey,
+                                int             aIndex,
+                                const uint8_t **aData,
+                                uint16_t       *aLength);
+
 /**
  * Sets or replaces the value of a setting.
  *
@@ -181,6 +367,66 @@ tinyError tyPlatSettingsAdd(tinyInstance *aInstance, uint16_t aKey, const uint8_
  */
 tinyError tyPlatSettingsDelete(tinyInstance *aInstance, uint16_t aKey, int aIndex);
 
+/**
+ * Identifies a single value of a setting independently of its index.
+ *
+ * A handle stays valid while its value is in the setting store, also when the settings are deinitialized and
+ * initialized again. Unlike an index it is not affected by other values being added or deleted. The handle of a
+ * deleted value may later be reused for another value of the same key.
+ */
+typedef uint64_t tyPlatSettingsHandle;
+
+/**
+ * Adds a value to a setting like `tyPlatSettingsAdd()` and returns a handle to the value.
+ *
+ * @param[in]   aInstance     The OpenThread instance structure.
+ * @param[in]   aKey          The key associated with the setting to change.
+ * @param[in]   aValue        A pointer to where the new value of the setting should be read from. MUST NOT be NULL
+ *                            if @p aValueLength is non-zero.
+ * @param[in]   aValueLength  The length of the data pointed to by @p aValue. May be zero.
+ * @param[out]  aHandle       A pointer to where the handle of the value should be written. May be NULL.
+ *
+ * @retval TY_ERROR_NONE             The given setting was added or staged to be added.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ * @retval TY_ERROR_NO_BUFS          No space remaining to store the given setting.
+ */
+tinyError tyPlatSettingsAddWithHandle(tinyInstance         *aInstance,
+                                      uint16_t              aKey,
+                                      const uint8_t        *aValue,
+                                      uint16_t              aValueLength,
+                                      tyPlatSettingsHandle *aHandle);
+
+/**
+ * Fetches the value of a setting by its handle.
+ *
+ * @p aValue and @p aValueLength are used like with `tyPlatSettingsGet()`.
+ *
+ * @param[in]      aInstance     The OpenThread instance structure.
+ * @param[in]      aHandle       The handle of the value, as returned by `tyPlatSettingsAddWithHandle()`.
+ * @param[out]     aValue        A pointer to where the value of the setting should be written. May be NULL.
+ * @param[in,out]  aValueLength  A pointer to the length of the value. May be NULL.
+ *
+ * @retval TY_ERROR_NONE             The value was found and fetched successfully.
+ * @retval TY_ERROR_NOT_FOUND        The value was not found in the setting store.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsGetByHandle(tinyInstance        *aInstance,
+                                    tyPlatSettingsHandle aHandle,
+                                    uint8_t             *aValue,
+                                    uint16_t            *aValueLength);
+
+/**
+ * Removes a value of a setting by its handle.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ * @param[in]  aHandle    The handle of the value, as returned by `tyPlatSettingsAddWithHandle()`.
+ *
+ * @retval TY_ERROR_NONE             The value was found and removed successfully.
+ * @retval TY_ERROR_NOT_FOUND        The value was not found in the setting store.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsDeleteByHandle(tinyInstance *aInstance, tyPlatSettingsHandle aHandle);
+
 /**
  * Removes all settings from the setting store.
  *
@@ -191,6 +437,273 @@ tinyError tyPlatSettingsDelete(tinyInstance *aInstance, uint16_t aKey, int aInde
  */
 void tyPlatSettingsWipe(tinyInstance *aInstance);
 
+/**
+ * Writes all pending changes to the non-volatile setting store.
+ *
+ * Platforms which defer writes, e.g. the write-back mode of the POSIX platform, write all pending changes before
+ * returning. On other platforms this function has no effect.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ *
+ * @retval TY_ERROR_NONE           All changes are written to the non-volatile setting store.
+ * @retval TY_ERROR_INVALID_STATE  A batch is active, its changes are written by `tyPlatSettingsCommitBatch()`.
+ * @retval TY_ERROR_FAILED         The pending changes could not be written.
+ */
+tinyError tyPlatSettingsFlush(tinyInstance *aInstance);
+
+/**
+ * Starts a batch of changes to the setting store.
+ *
+ * All subsequent calls to `tyPlatSettingsSet()`, `tyPlatSettingsAdd()`, `tyPlatSettingsDelete()` and
+ * `tyPlatSettingsWipe()` are staged until `tyPlatSettingsCommitBatch()` writes them to the setting store at once, or
+ * `tyPlatSettingsAbortBatch()` discards them. The changes of a batch are applied atomically: after a power loss the
+ * setting store contains either all or none of them. `tyPlatSettingsGet()` returns the staged values while the batch
+ * is active.
+ *
+ * Changes of settings with sensitive keys are staged as well. On the POSIX platform they are kept in a secure store of
+ * their own, which like each shard applies its part of a batch atomically on its own.
+ *
+ * If batches are not implemented on the platform, changes are written immediately as if no batch was started.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ *
+ * @retval TY_ERROR_NONE             The batch was started.
+ * @retval TY_ERROR_INVALID_STATE    A batch is already active.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsBeginBatch(tinyInstance *aInstance);
+
+/**
+ * Writes all changes staged by the active batch to the setting store.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ *
+ * @retval TY_ERROR_NONE             The staged changes were written.
+ * @retval TY_ERROR_INVALID_STATE    No batch is active.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsCommitBatch(tinyInstance *aInstance);
+
+/**
+ * Discards all changes staged by the active batch.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ *
+ * @retval TY_ERROR_NONE             The staged changes were discarded.
+ * @retval TY_ERROR_INVALID_STATE    No batch is active.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsAbortBatch(tinyInstance *aInstance);
+
+/**
+ * Is called when an asynchronous change of the setting store is written to non-volatile storage.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ * @param[in]  aError     TY_ERROR_NONE if the change is written.
+ * @param[in]  aContext   The context passed along with the change.
+ */
+typedef void (*tyPlatSettingsCallback)(tinyInstance *aInstance, tinyError aError, void *aContext);
+
+/**
+ * Sets or replaces the value of a setting without waiting for it to be written to non-volatile storage.
+ *
+ * The new value is returned by `tyPlatSettingsGet()` as soon as this function returns. Once the change is written,
+ * @p aCallback is called from `tyPlatSettingsProcess()`. Changes which are written together share one write.
+ *
+ * @param[in]  aInstance     The OpenThread instance structure.
+ * @param[in]  aKey          The key associated with the setting to change.
+ * @param[in]  aValue        A pointer to where the new value of the setting should be read from.
+ * @param[in]  aValueLength  The length of the data pointed to by @p aValue.
+ * @param[in]  aCallback     The function to call once the change is written. May be NULL.
+ * @param[in]  aContext      A pointer passed to @p aCallback.
+ *
+ * @retval TY_ERROR_NONE             The setting was changed, @p aCallback is called once it is written.
+ * @retval TY_ERROR_INVALID_STATE    A batch is active.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsSetAsync(tinyInstance          *aInstance,
+                                 uint16_t               aKey,
+                                 const uint8_t         *aValue,
+                                 uint16_t               aValueLength,
+                                 tyPlatSettingsCallback aCallback,
+                                 void                  *aContext);
+
+/**
+ * Adds a value to a setting without waiting for it to be written to non-volatile storage.
+ *
+ * See `tyPlatSettingsSetAsync()`.
+ *
+ * @param[in]  aInstance     The OpenThread instance structure.
+ * @param[in]  aKey          The key associated with the setting to change.
+ * @param[in]  aValue        A pointer to where the new value of the setting should be read from.
+ * @param[in]  aValueLength  The length of the data pointed to by @p aValue.
+ * @param[in]  aCallback     The function to call once the change is written. May be NULL.
+ * @param[in]  aContext      A pointer passed to @p aCallback.
+ *
+ * @retval TY_ERROR_NONE             The value was added, @p aCallback is called once it is written.
+ * @retval TY_ERROR_INVALID_STATE    A batch is active.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsAddAsync(tinyInstance          *aInstance,
+                                 uint16_t               aKey,
+                                 const uint8_t         *aValue,
+                                 uint16_t               aValueLength,
+                                 tyPlatSettingsCallback aCallback,
+                                 void                  *aContext);
+
+/**
+ * Removes a value of a setting without waiting for the removal to be written to non-volatile storage.
+ *
+ * See `tyPlatSettingsSetAsync()`.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ * @param[in]  aKey       The key associated with the requested setting.
+ * @param[in]  aIndex     The index of the value to be removed. If set to -1, all values for this @p aKey will be
+ *                        removed.
+ * @param[in]  aCallback  The function to call once the removal is written. May be NULL.
+ * @param[in]  aContext   A pointer passed to @p aCallback.
+ *
+ * @retval TY_ERROR_NONE             The value was removed, @p aCallback is called once the removal is written.
+ * @retval TY_ERROR_NOT_FOUND        The given key or index was not found in the setting store.
+ * @retval TY_ERROR_INVALID_STATE    A batch is active.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsDeleteAsync(tinyInstance          *aInstance,
+                                    uint16_t               aKey,
+                                    int                    aIndex,
+                                    tyPlatSettingsCallback aCallback,
+                                    void                  *aContext);
+
+/**
+ * Gets a file descriptor which becomes readable when callbacks of asynchronous changes are ready to be called.
+ *
+ * The event loop of the instance polls the file descriptor and calls `tyPlatSettingsProcess()` when it is readable.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ *
+ * @returns The file descriptor, or -1 if asynchronous changes are not implemented on this platform.
+ */
+int tyPlatSettingsGetEventFd(tinyInstance *aInstance);
+
+/**
+ * Calls the callbacks of all asynchronous changes which are written to non-volatile storage.
+ *
+ * MUST be called from the thread of the instance. `tyPlatSettingsDeinit()` waits for all pending changes and calls
+ * their callbacks before it returns.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ */
+void tyPlatSettingsProcess(tinyInstance *aInstance);
+
+/**
+ * Writes a point-in-time consistent image of the settings store to a file descriptor, e.g. for a backup.
+ *
+ * The image contains at least all changes made before the call, but not those of an active batch. Writers are not
+ * blocked while it is copied. The image is written from the current position of @p aFd on and is not synced.
+ *
+ * Settings with sensitive keys are not part of the image.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ * @param[in]  aFd        The file descriptor to write the image to.
+ *
+ * @retval TY_ERROR_NONE             The image was written.
+ * @retval TY_ERROR_FAILED           The image could not be written to @p aFd.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsSnapshot(tinyInstance *aInstance, int aFd);
+
+/**
+ * Replaces all settings with an image written by `tyPlatSettingsSnapshot()`.
+ *
+ * The image is validated as a whole before any setting is changed. The settings are then replaced by a single batch,
+ * see `tyPlatSettingsBeginBatch()`. With more than one shard on the POSIX platform each shard is replaced atomically on
+ * its own, see `TYSETTINGS_POSIX_CONFIG_SHARDS`: after a power loss some shards may hold the restored settings and the
+ * others their previous ones.
+ *
+ * Settings with sensitive keys are kept, unless the image holds values of their key, e.g. as it was written before the
+ * key became sensitive.
+ *
+ * @param[in]  aInstance  The OpenThread instance structure.
+ * @param[in]  aFd        The file descriptor of the image, a regular file.
+ *
+ * @retval TY_ERROR_NONE             The settings were replaced.
+ * @retval TY_ERROR_PARSE            The image could not be read or is not valid, no setting was changed.
+ * @retval TY_ERROR_INVALID_STATE    A batch is active.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  This function is not implemented on this platform.
+ */
+tinyError tyPlatSettingsRestore(tinyInstance *aInstance, int aFd);
+
+/**
+ * Identifies the operations whose latency is measured by `tyPlatSettingsGetStats()`.
+ */
+typedef enum tyPlatSettingsOperation
+{
+    TY_PLAT_SETTINGS_OPERATION_GET    = 0, ///< Fetching values, by `tyPlatSettingsGet()` and its variants.
+    TY_PLAT_SETTINGS_OPERATION_SET    = 1, ///< `tyPlatSettingsSet()` and `tyPlatSettingsSetAsync()`.
+    TY_PLAT_SETTINGS_OPERATION_ADD    = 2, ///< `tyPlatSettingsAdd()` and its variants.
+    TY_PLAT_SETTINGS_OPERATION_DELETE = 3, ///< `tyPlatSettingsDelete()` and its variants.
+    TY_PLAT_SETTINGS_OPERATION_WIPE   = 4, ///< `tyPlatSettingsWipe()`.
+    TY_PLAT_SETTINGS_NUM_OPERATIONS   = 5, ///< The number of operations.
+} tyPlatSettingsOperation;
+
+/**
+ * The number of buckets of a latency histogram.
+ */
+#define TY_PLAT_SETTINGS_STATS_NUM_BUCKETS 32
+
+/**
+ * Counts the calls of an operation.
+ */
+typedef struct tyPlatSettingsOperationStats
+{
+    uint64_t mCount; ///< The number of calls.
+
+    /**
+     * The latency histogram. Bucket 0 counts calls which took less than 2 ns, bucket i calls which took at least 2^i
+     * but less than 2^(i+1) ns. The last bucket also counts all longer calls.
+     */
+    uint64_t mLatency[TY_PLAT_SETTINGS_STATS_NUM_BUCKETS];
+} tyPlatSettingsOperationStats;
+
+/**
+ * Holds the statistics of the setting store of an instance.
+ */
+typedef struct tyPlatSettingsStats
+{
+    tyPlatSettingsOperationStats mOperations[TY_PLAT_SETTINGS_NUM_OPERATIONS]; ///< Indexed by operation.
+
+    uint64_t mBytesRead;      ///< The number of value bytes read from the store.
+    uint64_t mBytesWritten;   ///< The number of bytes written to the store, including rewritten records.
+    uint64_t mCommits;        ///< The number of times changes were synced or committed to non-volatile storage.
+    uint64_t mBytesRewritten; ///< The number of bytes of unchanged records copied when the store was rewritten.
+} tyPlatSettingsStats;
+
+/**
+ * Gets the statistics of the setting store, counted since `tyPlatSettingsInit()`.
+ *
+ * Counters the platform does not keep are 0.
+ *
+ * @param[in]   aInstance  The OpenThread instance structure.
+ * @param[out]  aStats     A pointer to where the statistics should be written.
+ *
+ * @retval TY_ERROR_NONE             The statistics were written to @p aStats.
+ * @retval TY_ERROR_NOT_IMPLEMENTED  Statistics are disabled by `TYSETTINGS_CONFIG_STATS_ENABLE` or not implemented on
+ *                                   this platform.
+ */
+tinyError tyPlatSettingsGetStats(tinyInstance *aInstance, tyPlatSettingsStats *aStats);
+
+/**
+ * Records a trace probe of the settings store.
+ *
+ * Called when `TYSETTINGS_CONFIG_TRACE_ENABLE` is set on platforms without native trace probes, i.e. neither USDT
+ * on Linux nor the tracing subsystem of Zephyr. It must be provided by the application and must not call back into
+ * the settings store.
+ *
+ * @param[in]  aProbe  The name of the probe, e.g. "tysettings:nvs_commit__start".
+ * @param[in]  aArg    The argument of the probe, e.g. a key or a number of bytes.
+ */
+void tyPlatSettingsTrace(const char *aProbe, uint64_t aArg);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
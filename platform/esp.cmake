@@ -1,11 +1,12 @@
 cmake_minimum_required(VERSION 3.20)
 
-idf_component_register(PRIV_REQUIRES nvs_flash esp_partition)
+idf_component_register(PRIV_REQUIRES nvs_flash esp_partition esp_timer)
 
 ty_library_named(tysettings)
 ty_library_include_directories_public(${PROJECT_DIR}/include)
 ty_library_link_libraries(tiny)
 ty_library_link_libraries(__idf_nvs_flash)
+ty_library_link_libraries(__idf_esp_timer)
 add_subdirectory(${PROJECT_DIR}/src)
 
 target_link_libraries(${COMPONENT_LIB} INTERFACE tysettings)
@@ -2,6 +2,9 @@ cmake_minimum_required(VERSION 3.20)
 
 ty_library_named(tysettings)
 ty_library_link_libraries(tiny)
+
+find_package(Threads REQUIRED)
+ty_library_link_libraries(Threads::Threads)
 ty_library_include_directories_public(${PROJECT_DIR}/include)
 
 add_subdirectory(${PROJECT_DIR}/src)
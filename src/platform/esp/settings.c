@@ -3,7 +3,12 @@
 
 #include "tysettings/platform/settings.h"
 #include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
 #include "nvs.h"
+#include "tysettings-compress.h"
+#include "tysettings-config.h"
+#include "tysettings-trace.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,16 +21,237 @@
 #define TY_KEY_INDEX_PATTERN "TS%02x%02x"
 #define TY_KEY_PATTERN_LEN 5
 #define TY_KEY_INDEX_PATTERN_LEN 7
+#define TY_GET_MANY_BATCH 16
+#define TY_ITER_POSITION_NVS UINT32_MAX
 static nvs_handle_t s_ot_nvs_handle;
 static const char  *s_storage_name;
 
 const char *TY_PLAT_LOG_TAG = "settings";
 
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+static tyPlatSettingsStats s_stats;
+static portMUX_TYPE        s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+struct ty_settings_timer
+{
+    tyPlatSettingsOperation operation;
+    int64_t                 start;
+};
+
+static void ty_settings_count(uint64_t *counter, uint64_t value)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    *counter += value;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+static void ty_settings_timer_stop(struct ty_settings_timer *timer)
+{
+    uint64_t                      latency = (uint64_t)(esp_timer_get_time() - timer->start) * 1000;
+    tyPlatSettingsOperationStats *stats   = &s_stats.mOperations[timer->operation];
+    unsigned int                  bucket  = 0;
+
+    // Bucket i holds latencies of [2^i, 2^(i+1)) ns, the last bucket everything above.
+    if (latency >= 2)
+    {
+        bucket = 63 - __builtin_clzll(latency);
+    }
+    if (bucket >= TY_PLAT_SETTINGS_STATS_NUM_BUCKETS)
+    {
+        bucket = TY_PLAT_SETTINGS_STATS_NUM_BUCKETS - 1;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    stats->mCount++;
+    stats->mLatency[bucket]++;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+// Measures the rest of the calling function as a call of the operation, with the resolution of esp_timer.
+#define TY_SETTINGS_MEASURE(op)                                                                      \
+    struct ty_settings_timer ty_settings_timer __attribute__((cleanup(ty_settings_timer_stop))) = { \
+        .operation = (op), .start = esp_timer_get_time()}
+#define TY_SETTINGS_COUNT(counter, value) ty_settings_count(&s_stats.counter, (value))
+#else
+#define TY_SETTINGS_MEASURE(op)
+#define TY_SETTINGS_COUNT(counter, value)
+#endif
+
+static esp_err_t ty_settings_commit(void)
+{
+    esp_err_t ret;
+
+    TY_SETTINGS_TRACE(nvs_commit__start, 0);
+    ret = nvs_commit(s_ot_nvs_handle);
+    TY_SETTINGS_TRACE(nvs_commit__done, ret);
+    TY_SETTINGS_COUNT(mCommits, 1);
+
+    return ret;
+}
+
+// Reads a blob like nvs_get_blob(), values in an envelope are decoded and truncated to the size of the buffer.
+static esp_err_t ty_settings_get_blob(const char *key, uint8_t *value, size_t *length)
+{
+#if TYSETTINGS_CONFIG_COMPRESS_THRESHOLD > 0
+    size_t    blob_length  = 0;
+    uint16_t  value_length = (*length > UINT16_MAX) ? UINT16_MAX : (uint16_t)*length;
+    uint8_t  *blob;
+    esp_err_t ret = nvs_get_blob(s_ot_nvs_handle, key, NULL, &blob_length);
+
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    // NVS only reads whole blobs, the envelope is decoded from a copy on the heap.
+    blob = malloc((blob_length > 0) ? blob_length : 1);
+    if (blob == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    ret = nvs_get_blob(s_ot_nvs_handle, key, blob, &blob_length);
+    if (ret == ESP_OK && !tySettingsDecodeBlob(blob, blob_length, value, &value_length))
+    {
+        ret = ESP_FAIL;
+    }
+    free(blob);
+    *length = value_length;
+    return ret;
+#else
+    return nvs_get_blob(s_ot_nvs_handle, key, value, length);
+#endif
+}
+
+// Writes a blob, values of at least TYSETTINGS_CONFIG_COMPRESS_THRESHOLD bytes are compressed into an envelope.
+static esp_err_t ty_settings_set_blob(const char *key, const uint8_t *value, uint16_t length)
+{
+    esp_err_t ret;
+#if TYSETTINGS_CONFIG_COMPRESS_THRESHOLD > 0
+    size_t   blob_size = (size_t)length + TY_SETTINGS_ENVELOPE_HEADER_SIZE;
+    uint8_t *blob      = malloc(blob_size);
+    size_t   blob_length;
+
+    if (blob == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    blob_length = tySettingsEncodeBlob(value, length, blob, blob_size);
+    if (blob_length != 0)
+    {
+        ret = nvs_set_blob(s_ot_nvs_handle, key, blob, blob_length);
+    }
+    else
+    {
+        blob_length = length;
+        ret         = nvs_set_blob(s_ot_nvs_handle, key, value, length);
+    }
+    free(blob);
+    if (ret == ESP_OK)
+    {
+        TY_SETTINGS_COUNT(mBytesWritten, blob_length);
+    }
+#else
+    ret = nvs_set_blob(s_ot_nvs_handle, key, value, length);
+    if (ret == ESP_OK)
+    {
+        TY_SETTINGS_COUNT(mBytesWritten, length);
+    }
+#endif
+    return ret;
+}
+
 void esp_openthread_set_storage_name(const char *name)
 {
     s_storage_name = name;
 }
 
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+// An NVS entry name, made of the lower byte of the key and the position of the value.
+struct ty_name_cache_entry
+{
+    uint8_t key;
+    uint8_t pos;
+};
+
+// The names of all values in the namespace, the values of a key are indexed in the order of their names here.
+static struct ty_name_cache_entry s_name_cache[TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE];
+static size_t                     s_name_cache_count;
+static bool                       s_name_cache_valid;
+
+static int ty_name_cache_find(uint8_t key, uint8_t pos)
+{
+    for (size_t i = 0; i < s_name_cache_count; i++)
+    {
+        if (s_name_cache[i].key == key && s_name_cache[i].pos == pos)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int ty_name_cache_find_index(uint8_t key, int index)
+{
+    for (size_t i = 0; i < s_name_cache_count; i++)
+    {
+        if (s_name_cache[i].key == key && index-- == 0)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Adds the name of a value which is not cached yet, names which do not fit invalidate the cache.
+static void ty_name_cache_add(uint8_t key, uint8_t pos)
+{
+    if (!s_name_cache_valid)
+    {
+        return;
+    }
+    if (s_name_cache_count == TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE)
+    {
+        ESP_LOGW(TY_PLAT_LOG_TAG, "NVS name cache is full, names are looked up in NVS");
+        s_name_cache_valid = false;
+        return;
+    }
+    s_name_cache[s_name_cache_count].key = key;
+    s_name_cache[s_name_cache_count].pos = pos;
+    s_name_cache_count++;
+}
+
+static void ty_name_cache_remove(int slot)
+{
+    if (slot < 0)
+    {
+        return;
+    }
+    memmove(&s_name_cache[slot], &s_name_cache[slot + 1], (s_name_cache_count - slot - 1) * sizeof(s_name_cache[0]));
+    s_name_cache_count--;
+}
+
+// Reads the names of all values in the namespace, the cache stays invalid if they cannot be read.
+static void ty_name_cache_load(void)
+{
+    nvs_iterator_t nvs_it = NULL;
+    esp_err_t      ret    = nvs_entry_find(TY_PART_NAME, TY_NAMESPACE, NVS_TYPE_BLOB, &nvs_it);
+
+    s_name_cache_count = 0;
+    s_name_cache_valid = (ret == ESP_OK || ret == ESP_ERR_NVS_NOT_FOUND);
+    while (ret == ESP_OK && s_name_cache_valid)
+    {
+        nvs_entry_info_t info;
+        nvs_entry_info(nvs_it, &info);
+        if (strlen(info.key) == TY_KEY_INDEX_PATTERN_LEN - 1 && memcmp(info.key, "TS", 2) == 0)
+        {
+            char key_hex[3] = {info.key[2], info.key[3], '\0'};
+            char pos_hex[3] = {info.key[4], info.key[5], '\0'};
+            ty_name_cache_add((uint8_t)strtoul(key_hex, NULL, 16), (uint8_t)strtoul(pos_hex, NULL, 16));
+        }
+        ret = nvs_entry_next(&nvs_it);
+    }
+    nvs_release_iterator(nvs_it);
+}
+#endif
+
 static esp_err_t get_next_empty_index(uint16_t aKey, uint8_t *index)
 {
     ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), ESP_ERR_INVALID_STATE, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
@@ -35,6 +261,21 @@ static esp_err_t get_next_empty_index(uint16_t aKey, uint8_t *index)
     nvs_iterator_t          nvs_it                               = NULL;
     bool                    found                                = false;
 
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    if (s_name_cache_valid)
+    {
+        for (uint8_t i = 0; i != UINT8_MAX; i++)
+        {
+            s_unused_pos++;
+            if (ty_name_cache_find((uint8_t)aKey, s_unused_pos) < 0)
+            {
+                *index = s_unused_pos;
+                return ESP_OK;
+            }
+        }
+        return ESP_ERR_NOT_FOUND;
+    }
+#endif
     for (uint8_t i = 0; i != UINT8_MAX; i++)
     {
         s_unused_pos++;
@@ -74,6 +315,19 @@ static esp_err_t find_target_key_using_index(uint16_t aKey, int aIndex, char *ke
     int            cur_index                      = 0;
     char           ot_nvs_key[TY_KEY_PATTERN_LEN] = {0};
 
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    if (s_name_cache_valid)
+    {
+        int slot = ty_name_cache_find_index((uint8_t)aKey, aIndex);
+
+        if (slot < 0)
+        {
+            return ESP_FAIL;
+        }
+        snprintf(key, key_len, TY_KEY_INDEX_PATTERN, s_name_cache[slot].key, s_name_cache[slot].pos);
+        return ESP_OK;
+    }
+#endif
     ret = nvs_entry_find(TY_PART_NAME, TY_NAMESPACE, NVS_TYPE_BLOB, &nvs_it);
     if (ret != ESP_OK)
     {
@@ -107,6 +361,59 @@ static esp_err_t find_target_key_using_index(uint16_t aKey, int aIndex, char *ke
     return ESP_OK;
 }
 
+/* Finds the NVS keys of up to TY_GET_MANY_BATCH requests in a single iteration, unresolved keys are left empty. */
+static esp_err_t find_target_keys_using_index(const tyPlatSettingsRequest *aRequests,
+                                              size_t                       aCount,
+                                              char (*keys)[TY_KEY_INDEX_PATTERN_LEN])
+{
+    esp_err_t      ret                                               = ESP_OK;
+    nvs_iterator_t nvs_it                                            = NULL;
+    int            cur_index[TY_GET_MANY_BATCH]                      = {0};
+    char           ot_nvs_key[TY_GET_MANY_BATCH][TY_KEY_PATTERN_LEN] = {0};
+
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    if (s_name_cache_valid)
+    {
+        for (size_t i = 0; i < aCount; i++)
+        {
+            int slot = ty_name_cache_find_index((uint8_t)aRequests[i].mKey, aRequests[i].mIndex);
+
+            if (slot >= 0)
+            {
+                snprintf(keys[i], TY_KEY_INDEX_PATTERN_LEN, TY_KEY_INDEX_PATTERN, s_name_cache[slot].key,
+                         s_name_cache[slot].pos);
+            }
+        }
+        return ESP_OK;
+    }
+#endif
+    ret = nvs_entry_find(TY_PART_NAME, TY_NAMESPACE, NVS_TYPE_BLOB, &nvs_it);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    for (size_t i = 0; i < aCount; i++)
+    {
+        snprintf(ot_nvs_key[i], sizeof(ot_nvs_key[i]), TY_KEY_PATTERN, (uint8_t)aRequests[i].mKey);
+    }
+    while (ret == ESP_OK)
+    {
+        nvs_entry_info_t info;
+        nvs_entry_info(nvs_it, &info);
+        for (size_t i = 0; i < aCount; i++)
+        {
+            if (memcmp(ot_nvs_key[i], info.key, TY_KEY_PATTERN_LEN - 1) == 0 &&
+                cur_index[i]++ == aRequests[i].mIndex)
+            {
+                memcpy(keys[i], info.key, TY_KEY_INDEX_PATTERN_LEN);
+            }
+        }
+        ret = nvs_entry_next(&nvs_it);
+    }
+    nvs_release_iterator(nvs_it);
+    return ESP_OK;
+}
+
 static esp_err_t erase_all_key(uint16_t aKey)
 {
     /* ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), ESP_ERR_INVALID_STATE, TY_PLAT_LOG_TAG, "OT NVS handle is
@@ -116,6 +423,26 @@ static esp_err_t erase_all_key(uint16_t aKey)
     nvs_iterator_t nvs_it                         = NULL;
     char           ot_nvs_key[TY_KEY_PATTERN_LEN] = {0};
 
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    if (s_name_cache_valid)
+    {
+        char name[TY_KEY_INDEX_PATTERN_LEN] = {0};
+        int  slot;
+
+        while ((slot = ty_name_cache_find_index((uint8_t)aKey, 0)) >= 0)
+        {
+            snprintf(name, sizeof(name), TY_KEY_INDEX_PATTERN, s_name_cache[slot].key, s_name_cache[slot].pos);
+            ret = nvs_erase_key(s_ot_nvs_handle, name);
+            if (ret != ESP_OK)
+            {
+                break;
+            }
+            ty_name_cache_remove(slot);
+        }
+        ret = ty_settings_commit();
+        return (ret == ESP_OK) ? ESP_OK : ESP_FAIL;
+    }
+#endif
     ret = nvs_entry_find(TY_PART_NAME, TY_NAMESPACE, NVS_TYPE_BLOB, &nvs_it);
     if (ret == ESP_ERR_NVS_NOT_FOUND)
     {
@@ -139,7 +466,7 @@ static esp_err_t erase_all_key(uint16_t aKey)
         ret = nvs_entry_next(&nvs_it);
     }
     nvs_release_iterator(nvs_it);
-    ret = nvs_commit(s_ot_nvs_handle);
+    ret = ty_settings_commit();
     if (ret != ESP_OK)
     {
         return ESP_FAIL;
@@ -147,14 +474,27 @@ static esp_err_t erase_all_key(uint16_t aKey)
     return ESP_OK;
 }
 
+tinyError tyPlatSettingsSetBaseName(tinyInstance *aInstance, const char *aBaseName)
+{
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
 void tyPlatSettingsInit(tinyInstance *aInstance, const uint16_t *aSensitiveKeys, uint16_t aSensitiveKeysLength)
 {
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+    portENTER_CRITICAL(&s_stats_lock);
+    memset(&s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&s_stats_lock);
+#endif
     esp_err_t err = nvs_open(TY_NAMESPACE, NVS_READWRITE, &s_ot_nvs_handle);
     if (err != ESP_OK)
     {
         ESP_LOGE(TY_PLAT_LOG_TAG, "Failed to open NVS namespace (0x%x)", err);
         assert(0);
     }
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    ty_name_cache_load();
+#endif
 }
 
 void tyPlatSettingsDeinit(tinyInstance *aInstance)
@@ -163,10 +503,14 @@ void tyPlatSettingsDeinit(tinyInstance *aInstance)
     {
         nvs_close(s_ot_nvs_handle);
     }
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    s_name_cache_valid = false;
+#endif
 }
 
 tinyError tyPlatSettingsGet(tinyInstance *aInstance, uint16_t aKey, int aIndex, uint8_t *aValue, uint16_t *aValueLength)
 {
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
     ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
     esp_err_t ret                                  = ESP_OK;
     char      ot_nvs_key[TY_KEY_INDEX_PATTERN_LEN] = {0};
@@ -177,28 +521,324 @@ tinyError tyPlatSettingsGet(tinyInstance *aInstance, uint16_t aKey, int aIndex,
         return TY_ERROR_NOT_FOUND;
     }
     size_t length = *aValueLength;
-    ret           = nvs_get_blob(s_ot_nvs_handle, ot_nvs_key, aValue, &length);
+    ret           = ty_settings_get_blob(ot_nvs_key, aValue, &length);
     *aValueLength = (uint16_t)length;
     ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "Data not found, err: %d", ret);
+    TY_SETTINGS_COUNT(mBytesRead, (aValue != NULL) ? length : 0);
     return TY_ERROR_NONE;
 }
 
+tinyError tyPlatSettingsGetMany(tinyInstance *aInstance, const tyPlatSettingsRequest *aRequests, size_t aCount)
+{
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
+    ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
+    tinyError error = TY_ERROR_NONE;
+
+    for (size_t first = 0; first < aCount; first += TY_GET_MANY_BATCH)
+    {
+        const tyPlatSettingsRequest *requests = &aRequests[first];
+        size_t count = (aCount - first < TY_GET_MANY_BATCH) ? aCount - first : TY_GET_MANY_BATCH;
+        char   ot_nvs_keys[TY_GET_MANY_BATCH][TY_KEY_INDEX_PATTERN_LEN] = {0};
+
+        find_target_keys_using_index(requests, count, ot_nvs_keys);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            tinyError request_error = TY_ERROR_NOT_FOUND;
+
+            if (ot_nvs_keys[i][0] != '\0')
+            {
+                size_t    length = (requests[i].mValueLength != NULL) ? *requests[i].mValueLength : 0;
+                esp_err_t ret    = ty_settings_get_blob(ot_nvs_keys[i],
+                                                        (requests[i].mValueLength != NULL) ? requests[i].mValue : NULL,
+                                                        &length);
+
+                if (ret == ESP_OK)
+                {
+                    if (requests[i].mValueLength != NULL)
+                    {
+                        *requests[i].mValueLength = (uint16_t)length;
+                        TY_SETTINGS_COUNT(mBytesRead, (requests[i].mValue != NULL) ? length : 0);
+                    }
+                    request_error = TY_ERROR_NONE;
+                }
+            }
+            if (requests[i].mError != NULL)
+            {
+                *requests[i].mError = request_error;
+            }
+            if (request_error != TY_ERROR_NONE)
+            {
+                error = request_error;
+            }
+        }
+    }
+    return error;
+}
+
+// Reads the value of an iteration, aValue and aValueLength are used like with tyPlatSettingsGet().
+static tinyError ty_settings_iter_read(const char *key, uint8_t *aValue, uint16_t *aValueLength)
+{
+    size_t    length = (aValueLength != NULL) ? *aValueLength : 0;
+    esp_err_t ret    = ty_settings_get_blob(key, (aValueLength != NULL) ? aValue : NULL, &length);
+    ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "Data not found, err: %d", ret);
+    if (aValueLength != NULL)
+    {
+        *aValueLength = (uint16_t)length;
+        TY_SETTINGS_COUNT(mBytesRead, (aValue != NULL) ? length : 0);
+    }
+    return TY_ERROR_NONE;
+}
+
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+// Continues an iteration at the cache slot of its position, the names it held are still iterated once the cache is
+// invalidated.
+static tinyError ty_name_cache_iter_next(tyPlatSettingsIter *aIter,
+                                         uint16_t           *aKey,
+                                         uint8_t            *aValue,
+                                         uint16_t           *aValueLength)
+{
+    while (aIter->mPosition < s_name_cache_count)
+    {
+        struct ty_name_cache_entry entry = s_name_cache[aIter->mPosition++];
+        char                       ot_nvs_key[TY_KEY_INDEX_PATTERN_LEN];
+        tinyError                  error;
+
+        if (aIter->mKey != -1 && entry.key != (uint8_t)aIter->mKey)
+        {
+            continue;
+        }
+        snprintf(ot_nvs_key, sizeof(ot_nvs_key), TY_KEY_INDEX_PATTERN, entry.key, entry.pos);
+        error = ty_settings_iter_read(ot_nvs_key, aValue, aValueLength);
+        if (error != TY_ERROR_NONE)
+        {
+            return error;
+        }
+        if (aKey != NULL)
+        {
+            // Only the lower byte of the key is part of the NVS key.
+            *aKey = (aIter->mKey == -1) ? entry.key : aIter->mNextKey;
+        }
+        aIter->mNextIndex++;
+        return TY_ERROR_NONE;
+    }
+    return TY_ERROR_NOT_FOUND;
+}
+#endif
+
+tinyError tyPlatSettingsIterBegin(tinyInstance *aInstance, tyPlatSettingsIter *aIter, int32_t aKey)
+{
+    if (aKey < -1 || aKey > UINT16_MAX)
+    {
+        return TY_ERROR_INVALID_ARGS;
+    }
+    aIter->mKey       = aKey;
+    aIter->mNextKey   = (aKey == -1) ? 0 : (uint16_t)aKey;
+    aIter->mNextIndex = 0;
+    aIter->mPosition  = TY_ITER_POSITION_NVS;
+    aIter->mContext   = NULL;
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    if (s_name_cache_valid)
+    {
+        // The cache orders the values like tyPlatSettingsGet() indexes them, NVS moves rewritten values to its end.
+        aIter->mPosition = 0;
+        return TY_ERROR_NONE;
+    }
+#endif
+    // The NVS iterator keeps the position within the namespace, a missing namespace has no values.
+    if (nvs_entry_find(TY_PART_NAME, TY_NAMESPACE, NVS_TYPE_BLOB, (nvs_iterator_t *)&aIter->mContext) != ESP_OK)
+    {
+        aIter->mContext = NULL;
+    }
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsIterNext(tinyInstance       *aInstance,
+                                 tyPlatSettingsIter *aIter,
+                                 uint16_t           *aKey,
+                                 uint8_t            *aValue,
+                                 uint16_t           *aValueLength)
+{
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
+    ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
+    nvs_iterator_t nvs_it                         = (nvs_iterator_t)aIter->mContext;
+    char           ot_nvs_key[TY_KEY_PATTERN_LEN] = {0};
+
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    if (aIter->mPosition != TY_ITER_POSITION_NVS)
+    {
+        return ty_name_cache_iter_next(aIter, aKey, aValue, aValueLength);
+    }
+#endif
+    snprintf(ot_nvs_key, sizeof(ot_nvs_key), TY_KEY_PATTERN, (uint8_t)aIter->mNextKey);
+    while (nvs_it != NULL)
+    {
+        nvs_entry_info_t info;
+        nvs_entry_info(nvs_it, &info);
+        if (nvs_entry_next(&nvs_it) != ESP_OK)
+        {
+            // nvs_entry_next() releases the iterator once the entries are exhausted.
+            nvs_it = NULL;
+        }
+        aIter->mContext = nvs_it;
+
+        if ((aIter->mKey == -1) ? (memcmp(ot_nvs_key, info.key, 2) == 0)
+                                : (memcmp(ot_nvs_key, info.key, TY_KEY_PATTERN_LEN - 1) == 0))
+        {
+            tinyError error = ty_settings_iter_read(info.key, aValue, aValueLength);
+            if (error != TY_ERROR_NONE)
+            {
+                return error;
+            }
+            if (aKey != NULL)
+            {
+                // Only the lower byte of the key is part of the NVS key.
+                char key_hex[3] = {info.key[2], info.key[3], '\0'};
+                *aKey           = (aIter->mKey == -1) ? (uint16_t)strtoul(key_hex, NULL, 16) : aIter->mNextKey;
+            }
+            aIter->mNextIndex++;
+            return TY_ERROR_NONE;
+        }
+    }
+    return TY_ERROR_NOT_FOUND;
+}
+
+void tyPlatSettingsIterEnd(tinyInstance *aInstance, tyPlatSettingsIter *aIter)
+{
+    nvs_release_iterator((nvs_iterator_t)aIter->mContext);
+    aIter->mContext = NULL;
+}
+
+// Reads a value into a copy on the heap and passes it to the callback of tyPlatSettingsForEach().
+static tinyError ty_settings_pass_value(tinyInstance                 *aInstance,
+                                        const char                   *key,
+                                        uint16_t                      aKey,
+                                        tyPlatSettingsForEachCallback aCallback,
+                                        void                         *aContext,
+                                        bool                         *aMore)
+{
+    size_t    length = 0;
+    uint8_t  *value;
+    esp_err_t ret = ty_settings_get_blob(key, NULL, &length);
+
+    ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_FAILED, TY_PLAT_LOG_TAG, "Data not readable, err: %d", ret);
+    value = malloc((length > 0) ? length : 1);
+    ESP_RETURN_ON_FALSE((value != NULL), TY_ERROR_NO_BUFS, TY_PLAT_LOG_TAG, "No buffers, err: %d", ESP_ERR_NO_MEM);
+    ret = ty_settings_get_blob(key, value, &length);
+    if (ret != ESP_OK)
+    {
+        free(value);
+        ESP_LOGE(TY_PLAT_LOG_TAG, "Data not readable, err: %d", ret);
+        return TY_ERROR_FAILED;
+    }
+    TY_SETTINGS_COUNT(mBytesRead, length);
+    *aMore = aCallback(aInstance, aKey, value, (uint16_t)length, aContext);
+    free(value);
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsForEach(tinyInstance                 *aInstance,
+                                int32_t                       aKey,
+                                tyPlatSettingsForEachCallback aCallback,
+                                void                         *aContext)
+{
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
+    ESP_RETURN_ON_FALSE((aKey >= -1 && aKey <= UINT16_MAX), TY_ERROR_INVALID_ARGS, TY_PLAT_LOG_TAG, "Invalid key");
+    ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_FAILED, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
+    tinyError      error                          = TY_ERROR_NONE;
+    bool           more                           = true;
+    nvs_iterator_t nvs_it                         = NULL;
+    char           ot_nvs_key[TY_KEY_PATTERN_LEN] = {0};
+    esp_err_t      ret;
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    char ot_nvs_key_index[TY_KEY_INDEX_PATTERN_LEN];
+#endif
+
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    if (s_name_cache_valid)
+    {
+        // The values are passed in the order of the iteration, which the cache holds.
+        for (size_t i = 0; i < s_name_cache_count && error == TY_ERROR_NONE && more; i++)
+        {
+            if (aKey == -1 || s_name_cache[i].key == (uint8_t)aKey)
+            {
+                snprintf(ot_nvs_key_index, sizeof(ot_nvs_key_index), TY_KEY_INDEX_PATTERN, s_name_cache[i].key,
+                         s_name_cache[i].pos);
+                error = ty_settings_pass_value(aInstance, ot_nvs_key_index,
+                                               (aKey == -1) ? s_name_cache[i].key : (uint16_t)aKey, aCallback,
+                                               aContext, &more);
+            }
+        }
+        return error;
+    }
+#endif
+    snprintf(ot_nvs_key, sizeof(ot_nvs_key), TY_KEY_PATTERN, (uint8_t)aKey);
+    // One pass over the namespace, values are only read when they match.
+    ret = nvs_entry_find(TY_PART_NAME, TY_NAMESPACE, NVS_TYPE_BLOB, &nvs_it);
+    while (ret == ESP_OK && error == TY_ERROR_NONE && more)
+    {
+        nvs_entry_info_t info;
+        nvs_entry_info(nvs_it, &info);
+        ret = nvs_entry_next(&nvs_it);
+
+        if ((aKey == -1) ? (memcmp(ot_nvs_key, info.key, 2) == 0)
+                         : (memcmp(ot_nvs_key, info.key, TY_KEY_PATTERN_LEN - 1) == 0))
+        {
+            // Only the lower byte of the key is part of the NVS key.
+            char key_hex[3] = {info.key[2], info.key[3], '\0'};
+
+            error = ty_settings_pass_value(aInstance, info.key,
+                                           (aKey == -1) ? (uint16_t)strtoul(key_hex, NULL, 16) : (uint16_t)aKey,
+                                           aCallback, aContext, &more);
+        }
+    }
+    nvs_release_iterator(nvs_it);
+    return error;
+}
+
+tinyError tyPlatSettingsGetView(tinyInstance   *aInstance,
+                                uint16_t        aKey,
+                                int             aIndex,
+                                const uint8_t **aData,
+                                uint16_t       *aLength)
+{
+    // NVS blobs can only be read by copying them out of flash.
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
 tinyError tyPlatSettingsSet(tinyInstance *aInstance, uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
 {
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_SET);
     ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
     esp_err_t ret                                  = ESP_OK;
     char      ot_nvs_key[TY_KEY_INDEX_PATTERN_LEN] = {0};
 
     snprintf(ot_nvs_key, sizeof(ot_nvs_key), TY_KEY_INDEX_PATTERN, (uint8_t)aKey, 0);
-    ret = nvs_set_blob(s_ot_nvs_handle, ot_nvs_key, aValue, aValueLength);
+    ret = ty_settings_set_blob(ot_nvs_key, aValue, aValueLength);
     ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_NO_BUFS, TY_PLAT_LOG_TAG, "No buffers, err: %d", ret);
-    ret = nvs_commit(s_ot_nvs_handle);
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    if (ty_name_cache_find((uint8_t)aKey, 0) < 0)
+    {
+        ty_name_cache_add((uint8_t)aKey, 0);
+    }
+#endif
+    ret = ty_settings_commit();
     ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_NO_BUFS, TY_PLAT_LOG_TAG, "OT NVS handle shut down, err: %d", ret);
     return TY_ERROR_NONE;
 }
 
 tinyError tyPlatSettingsAdd(tinyInstance *aInstance, uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
 {
+    return tyPlatSettingsAddWithHandle(aInstance, aKey, aValue, aValueLength, NULL);
+}
+
+tinyError tyPlatSettingsAddWithHandle(tinyInstance         *aInstance,
+                                      uint16_t              aKey,
+                                      const uint8_t        *aValue,
+                                      uint16_t              aValueLength,
+                                      tyPlatSettingsHandle *aHandle)
+{
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_ADD);
     ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
     esp_err_t ret = ESP_OK;
     uint8_t   unused_pos;
@@ -207,15 +847,63 @@ tinyError tyPlatSettingsAdd(tinyInstance *aInstance, uint16_t aKey, const uint8_
     ret = get_next_empty_index(aKey, &unused_pos);
     ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_NO_BUFS, TY_PLAT_LOG_TAG, "No buffers, err: %d", ret);
     snprintf(ot_nvs_key, sizeof(ot_nvs_key), TY_KEY_INDEX_PATTERN, (uint8_t)aKey, unused_pos);
-    ret = nvs_set_blob(s_ot_nvs_handle, ot_nvs_key, aValue, aValueLength);
+    ret = ty_settings_set_blob(ot_nvs_key, aValue, aValueLength);
     ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_NO_BUFS, TY_PLAT_LOG_TAG, "No buffers, err: %d", ret);
-    ret = nvs_commit(s_ot_nvs_handle);
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    ty_name_cache_add((uint8_t)aKey, unused_pos);
+#endif
+    ret = ty_settings_commit();
     ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_NO_BUFS, TY_PLAT_LOG_TAG, "OT NVS handle shut down, err: %d", ret);
+    if (aHandle != NULL)
+    {
+        // The handle holds both parts of the NVS key, the value is read and erased without searching it.
+        *aHandle = ((tyPlatSettingsHandle)aKey << 32) | unused_pos;
+    }
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsGetByHandle(tinyInstance        *aInstance,
+                                    tyPlatSettingsHandle aHandle,
+                                    uint8_t             *aValue,
+                                    uint16_t            *aValueLength)
+{
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
+    ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
+    esp_err_t ret                                  = ESP_OK;
+    char      ot_nvs_key[TY_KEY_INDEX_PATTERN_LEN] = {0};
+    size_t    length                               = (aValueLength != NULL) ? *aValueLength : 0;
+
+    snprintf(ot_nvs_key, sizeof(ot_nvs_key), TY_KEY_INDEX_PATTERN, (uint8_t)(aHandle >> 32), (uint8_t)aHandle);
+    ret = ty_settings_get_blob(ot_nvs_key, (aValueLength != NULL) ? aValue : NULL, &length);
+    ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "Data not found, err: %d", ret);
+    if (aValueLength != NULL)
+    {
+        *aValueLength = (uint16_t)length;
+        TY_SETTINGS_COUNT(mBytesRead, (aValue != NULL) ? length : 0);
+    }
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsDeleteByHandle(tinyInstance *aInstance, tyPlatSettingsHandle aHandle)
+{
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_DELETE);
+    ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
+    esp_err_t ret                                  = ESP_OK;
+    char      ot_nvs_key[TY_KEY_INDEX_PATTERN_LEN] = {0};
+
+    snprintf(ot_nvs_key, sizeof(ot_nvs_key), TY_KEY_INDEX_PATTERN, (uint8_t)(aHandle >> 32), (uint8_t)aHandle);
+    ret = nvs_erase_key(s_ot_nvs_handle, ot_nvs_key);
+    ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "Data not found, err: %d", ret);
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    ty_name_cache_remove(ty_name_cache_find((uint8_t)(aHandle >> 32), (uint8_t)aHandle));
+#endif
+    ty_settings_commit();
     return TY_ERROR_NONE;
 }
 
 tinyError tyPlatSettingsDelete(tinyInstance *aInstance, uint16_t aKey, int aIndex)
 {
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_DELETE);
     /* ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_NOT_FOUND, TY_PLAT_LOG_TAG, "OT NVS handle is
      * invalid.");
      */
@@ -234,12 +922,113 @@ tinyError tyPlatSettingsDelete(tinyInstance *aInstance, uint16_t aKey, int aInde
             return TY_ERROR_NOT_FOUND;
         }
         ret = nvs_erase_key(s_ot_nvs_handle, ot_nvs_key);
-        nvs_commit(s_ot_nvs_handle);
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+        if (ret == ESP_OK)
+        {
+            // The erased name is still the one of the index.
+            ty_name_cache_remove(ty_name_cache_find_index((uint8_t)aKey, aIndex));
+        }
+#endif
+        ty_settings_commit();
     }
     return TY_ERROR_NONE;
 }
 
 void tyPlatSettingsWipe(tinyInstance *aInstance)
 {
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_WIPE);
+#if TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE > 0
+    if (nvs_erase_all(s_ot_nvs_handle) == ESP_OK)
+    {
+        // The namespace is empty, all of its names are known again.
+        s_name_cache_count = 0;
+        s_name_cache_valid = true;
+    }
+#else
     nvs_erase_all(s_ot_nvs_handle);
+#endif
+}
+
+tinyError tyPlatSettingsFlush(tinyInstance *aInstance)
+{
+    ESP_RETURN_ON_FALSE((s_ot_nvs_handle != 0), TY_ERROR_FAILED, TY_PLAT_LOG_TAG, "OT NVS handle is invalid.");
+    esp_err_t ret = ty_settings_commit();
+    ESP_RETURN_ON_FALSE((ret == ESP_OK), TY_ERROR_FAILED, TY_PLAT_LOG_TAG, "OT NVS handle shut down, err: %d", ret);
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsBeginBatch(tinyInstance *aInstance)
+{
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsCommitBatch(tinyInstance *aInstance)
+{
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsAbortBatch(tinyInstance *aInstance)
+{
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsSetAsync(tinyInstance          *aInstance,
+                                 uint16_t               aKey,
+                                 const uint8_t         *aValue,
+                                 uint16_t               aValueLength,
+                                 tyPlatSettingsCallback aCallback,
+                                 void                  *aContext)
+{
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsAddAsync(tinyInstance          *aInstance,
+                                 uint16_t               aKey,
+                                 const uint8_t         *aValue,
+                                 uint16_t               aValueLength,
+                                 tyPlatSettingsCallback aCallback,
+                                 void                  *aContext)
+{
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsDeleteAsync(tinyInstance          *aInstance,
+                                    uint16_t               aKey,
+                                    int                    aIndex,
+                                    tyPlatSettingsCallback aCallback,
+                                    void                  *aContext)
+{
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsGetStats(tinyInstance *aInstance, tyPlatSettingsStats *aStats)
+{
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+    portENTER_CRITICAL(&s_stats_lock);
+    *aStats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+    return TY_ERROR_NONE;
+#else
+    return TY_ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+int tyPlatSettingsGetEventFd(tinyInstance *aInstance)
+{
+    return -1;
+}
+
+void tyPlatSettingsProcess(tinyInstance *aInstance)
+{
+}
+
+tinyError tyPlatSettingsSnapshot(tinyInstance *aInstance, int aFd)
+{
+    // The NVS partition is not a file, it is backed up by reading the flash partition.
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsRestore(tinyInstance *aInstance, int aFd)
+{
+    return TY_ERROR_NOT_IMPLEMENTED;
 }
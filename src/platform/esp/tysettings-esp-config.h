@@ -6,4 +6,28 @@
 
 #include "sdkconfig.h"
 
+#ifdef CONFIG_TYSETTINGS_STATS
+#define TYSETTINGS_CONFIG_STATS_ENABLE 1
+#endif
+
+#ifdef CONFIG_TYSETTINGS_TRACE
+#define TYSETTINGS_CONFIG_TRACE_ENABLE 1
+#endif
+
+#ifdef CONFIG_TYSETTINGS_COMPRESS_THRESHOLD
+#define TYSETTINGS_CONFIG_COMPRESS_THRESHOLD CONFIG_TYSETTINGS_COMPRESS_THRESHOLD
+#endif
+
+/**
+ * @def TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE
+ *
+ * The number of NVS entry names cached in RAM to look up a value by its key and index without iterating the NVS
+ * entries, 0 to not cache them. Once the names do not fit, they are looked up in NVS until the next initialization.
+ */
+#ifdef CONFIG_TYSETTINGS_NVS_NAME_CACHE
+#define TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE CONFIG_TYSETTINGS_NVS_NAME_CACHE_SIZE
+#else
+#define TYSETTINGS_ESP_CONFIG_NAME_CACHE_SIZE 0
+#endif
+
 #endif // TYSETTINGS_ESP_CONFIG_H_
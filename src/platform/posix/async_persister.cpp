@@ -0,0 +1,192 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file
+ *   This file implements the persisting of asynchronous settings changes on a helper thread.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <ty/common/code_utils.hpp>
+#include <ty/common/debug.hpp>
+#include <ty/exit_code.h>
+
+#include "async_persister.hpp"
+
+namespace ty {
+namespace Posix {
+
+void AsyncPersister::Init(void)
+{
+    VerifyOrDie(pipe(mEventFds) == 0, TY_EXIT_ERROR_ERRNO);
+
+    for (int fd : mEventFds)
+    {
+        VerifyOrDie(fcntl(fd, F_SETFL, O_NONBLOCK) == 0, TY_EXIT_ERROR_ERRNO);
+        VerifyOrDie(fcntl(fd, F_SETFD, FD_CLOEXEC) == 0, TY_EXIT_ERROR_ERRNO);
+    }
+}
+
+void AsyncPersister::Deinit(tinyInstance *aInstance)
+{
+    VerifyOrExit(mEventFds[0] != -1);
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        mStopping = true;
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+        mWriteBacks.clear();
+#endif
+    }
+
+    mPendingCondition.notify_one();
+
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+
+    Process(aInstance);
+
+    for (int &fd : mEventFds)
+    {
+        VerifyOrDie(close(fd) == 0, TY_EXIT_ERROR_ERRNO);
+        fd = -1;
+    }
+
+    mStopping = false;
+
+exit:
+    return;
+}
+
+void AsyncPersister::Submit(SettingsFile &aFile, uint64_t aChange, tyPlatSettingsCallback aCallback, void *aContext)
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        TY_ASSERT(mEventFds[0] != -1 && !mStopping);
+
+        mPending.push_back({&aFile, aChange, aCallback, aContext});
+
+        if (!mThread.joinable())
+        {
+            mThread = std::thread(&AsyncPersister::Run, this);
+        }
+    }
+
+    mPendingCondition.notify_one();
+}
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+void AsyncPersister::ScheduleWriteBack(SettingsFile &aFile)
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        TY_ASSERT(mEventFds[0] != -1 && !mStopping);
+
+        mWriteBacks.push_back(
+            {&aFile, std::chrono::steady_clock::now() +
+                         std::chrono::milliseconds(TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL)});
+
+        if (!mThread.joinable())
+        {
+            mThread = std::thread(&AsyncPersister::Run, this);
+        }
+    }
+
+    // The helper thread may be waiting without a deadline.
+    mPendingCondition.notify_one();
+}
+#endif
+
+void AsyncPersister::Process(tinyInstance *aInstance)
+{
+    std::vector<Operation> completed;
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        uint8_t                     events[16];
+
+        completed.swap(mCompleted);
+
+        while (read(mEventFds[0], events, sizeof(events)) > 0)
+        {
+        }
+
+        VerifyOrDie(errno == EAGAIN || errno == EWOULDBLOCK, TY_EXIT_ERROR_ERRNO);
+    }
+
+    // Callbacks are called without the lock, they may submit further changes.
+    for (const Operation &operation : completed)
+    {
+        if (operation.mCallback != nullptr)
+        {
+            operation.mCallback(aInstance, TY_ERROR_NONE, operation.mContext);
+        }
+    }
+}
+
+void AsyncPersister::Run(void)
+{
+    std::unique_lock<std::mutex> lock(mLock);
+
+    while (true)
+    {
+        Operation operation;
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+        if (!mWriteBacks.empty() && !mStopping)
+        {
+            WriteBack writeBack = mWriteBacks.front();
+
+            if (!mPendingCondition.wait_until(lock, writeBack.mDeadline,
+                                              [this]() { return mStopping || !mPending.empty(); }))
+            {
+                mWriteBacks.pop_front();
+
+                lock.unlock();
+                // Changes written meanwhile reset the interval, a later deadline covers them.
+                writeBack.mFile->WriteBackIfDue();
+                lock.lock();
+                continue;
+            }
+        }
+        else
+#endif
+        {
+            mPendingCondition.wait(lock, [this]() { return mStopping || !mPending.empty(); });
+        }
+
+        // Pending changes are still persisted when stopping.
+        if (mPending.empty())
+        {
+            break;
+        }
+
+        operation = mPending.front();
+        mPending.pop_front();
+
+        lock.unlock();
+        // Changes queued meanwhile are persisted along with this one, their `Persist()` returns immediately.
+        operation.mFile->Persist(operation.mChange);
+        lock.lock();
+
+        if (mCompleted.empty())
+        {
+            const uint8_t event = 1;
+
+            VerifyOrDie(write(mEventFds[1], &event, sizeof(event)) == sizeof(event), TY_EXIT_ERROR_ERRNO);
+        }
+
+        mCompleted.push_back(operation);
+    }
+}
+
+} // namespace Posix
+} // namespace ty
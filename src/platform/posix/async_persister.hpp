@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef TY_POSIX_PLATFORM_ASYNC_PERSISTER_HPP_
+#define TY_POSIX_PLATFORM_ASYNC_PERSISTER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tysettings/platform/settings.h>
+
+#include "settings_file.hpp"
+
+namespace ty {
+namespace Posix {
+
+/**
+ * Persists asynchronous changes of settings files on a helper thread.
+ *
+ * The helper thread blocks on writing and syncing the settings files instead of the thread of the instance. Completed
+ * changes are queued until the thread of the instance calls `Process()`, which it does when the file descriptor of
+ * `GetEventFd()` becomes readable. The helper thread is started by the first change.
+ *
+ * In write-back mode, the helper thread also writes changes held back by the settings files once
+ * `TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL` expires, see `ScheduleWriteBack()`.
+ */
+class AsyncPersister
+{
+public:
+    AsyncPersister(void)
+        : mStopping(false)
+    {
+        mEventFds[0] = -1;
+        mEventFds[1] = -1;
+    }
+
+    /**
+     * Creates the file descriptor signaling completed changes.
+     */
+    void Init(void);
+
+    /**
+     * Waits for all pending changes, calls their callbacks and stops the helper thread.
+     *
+     * @param[in]  aInstance  The instance the callbacks are called for.
+     */
+    void Deinit(tinyInstance *aInstance);
+
+    /**
+     * Queues a change to be persisted by the helper thread.
+     *
+     * @param[in]  aFile      The settings file the change was made to.
+     * @param[in]  aChange    The change returned by the settings file, 0 if there is nothing to persist.
+     * @param[in]  aCallback  The function to call once the change is persisted. May be `nullptr`.
+     * @param[in]  aContext   A pointer passed to @p aCallback.
+     */
+    void Submit(SettingsFile &aFile, uint64_t aChange, tyPlatSettingsCallback aCallback, void *aContext);
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    /**
+     * Arms the deadline of the changes held back by a settings file.
+     *
+     * Once `TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL` milliseconds passed, the helper thread writes the changes
+     * unless another write did so meanwhile. Deadlines which did not expire are dropped by `Deinit()`, the settings
+     * files write their changes when they are deinitialized.
+     *
+     * @param[in]  aFile  The settings file holding back changes.
+     */
+    void ScheduleWriteBack(SettingsFile &aFile);
+
+    /**
+     * Is passed to `SettingsFile::SetWriteBackHandler()` with the persister as context.
+     */
+    static void HandleWriteBack(SettingsFile &aFile, void *aContext)
+    {
+        static_cast<AsyncPersister *>(aContext)->ScheduleWriteBack(aFile);
+    }
+#endif
+
+    /**
+     * Calls the callbacks of all persisted changes.
+     *
+     * @param[in]  aInstance  The instance the callbacks are called for.
+     */
+    void Process(tinyInstance *aInstance);
+
+    /**
+     * Returns the file descriptor which is readable while persisted changes wait for `Process()`.
+     */
+    int GetEventFd(void) const { return mEventFds[0]; }
+
+private:
+    struct Operation
+    {
+        SettingsFile          *mFile;
+        uint64_t               mChange;
+        tyPlatSettingsCallback mCallback;
+        void                  *mContext;
+    };
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    struct WriteBack
+    {
+        SettingsFile                         *mFile;
+        std::chrono::steady_clock::time_point mDeadline;
+    };
+#endif
+
+    void Run(void);
+
+    std::mutex              mLock; ///< Protects the queues and `mStopping`.
+    std::condition_variable mPendingCondition;
+    std::deque<Operation>   mPending;   ///< Changes waiting for the helper thread.
+    std::vector<Operation>  mCompleted; ///< Persisted changes waiting for `Process()`.
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    std::deque<WriteBack> mWriteBacks; ///< Armed deadlines, ordered as they all follow the same interval.
+#endif
+    bool                    mStopping;
+    std::thread             mThread;
+    int                     mEventFds[2]; ///< The read and write end of a pipe, readable while `mCompleted` is
+                                          ///< not empty.
+};
+
+} // namespace Posix
+} // namespace ty
+
+#endif // TY_POSIX_PLATFORM_ASYNC_PERSISTER_HPP_
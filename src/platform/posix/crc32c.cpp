@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file
+ *   This file implements the CRC32C checksum of the settings file records.
+ */
+
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#include "crc32c.hpp"
+
+namespace ty {
+namespace Posix {
+
+namespace {
+
+constexpr uint32_t kPolynomial = 0x82f63b78; ///< The reflected Castagnoli polynomial.
+
+struct Crc32cTables
+{
+    constexpr Crc32cTables(void)
+        : mTable()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+            }
+
+            mTable[0][i] = crc;
+        }
+
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            for (int slice = 1; slice < 8; slice++)
+            {
+                mTable[slice][i] = (mTable[slice - 1][i] >> 8) ^ mTable[0][mTable[slice - 1][i] & 0xff];
+            }
+        }
+    }
+
+    uint32_t mTable[8][256];
+};
+
+constexpr Crc32cTables kTables;
+
+uint32_t Crc32cSoftware(uint32_t aCrc, const uint8_t *aData, size_t aLength)
+{
+    const auto &table = kTables.mTable;
+
+    for (; aLength >= 8; aData += 8, aLength -= 8)
+    {
+        uint32_t low;
+        uint32_t high;
+
+        memcpy(&low, aData, sizeof(low));
+        memcpy(&high, aData + 4, sizeof(high));
+        low ^= aCrc;
+
+        aCrc = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^ table[5][(low >> 16) & 0xff] ^
+               table[4][low >> 24] ^ table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff] ^
+               table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+    }
+
+    for (; aLength > 0; aData++, aLength--)
+    {
+        aCrc = (aCrc >> 8) ^ table[0][(aCrc ^ *aData) & 0xff];
+    }
+
+    return aCrc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t Crc32cHardware(uint32_t aCrc, const uint8_t *aData, size_t aLength)
+{
+    uint64_t crc = aCrc;
+
+    for (; aLength >= 8; aData += 8, aLength -= 8)
+    {
+        uint64_t word;
+
+        memcpy(&word, aData, sizeof(word));
+        crc = _mm_crc32_u64(crc, word);
+    }
+
+    for (; aLength > 0; aData++, aLength--)
+    {
+        crc = _mm_crc32_u8(static_cast<uint32_t>(crc), *aData);
+    }
+
+    return static_cast<uint32_t>(crc);
+}
+
+const bool kHasHardware = __builtin_cpu_supports("sse4.2");
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+uint32_t Crc32cHardware(uint32_t aCrc, const uint8_t *aData, size_t aLength)
+{
+    for (; aLength >= 8; aData += 8, aLength -= 8)
+    {
+        uint64_t word;
+
+        memcpy(&word, aData, sizeof(word));
+        aCrc = __crc32cd(aCrc, word);
+    }
+
+    for (; aLength > 0; aData++, aLength--)
+    {
+        aCrc = __crc32cb(aCrc, *aData);
+    }
+
+    return aCrc;
+}
+
+const bool kHasHardware = true;
+#else
+uint32_t Crc32cHardware(uint32_t aCrc, const uint8_t *aData, size_t aLength)
+{
+    return Crc32cSoftware(aCrc, aData, aLength);
+}
+
+const bool kHasHardware = false;
+#endif
+
+} // namespace
+
+uint32_t Crc32c(uint32_t aCrc, const void *aData, size_t aLength)
+{
+    const uint8_t *data = static_cast<const uint8_t *>(aData);
+
+    aCrc = ~aCrc;
+    aCrc = kHasHardware ? Crc32cHardware(aCrc, data, aLength) : Crc32cSoftware(aCrc, data, aLength);
+
+    return ~aCrc;
+}
+
+} // namespace Posix
+} // namespace ty
@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef TY_POSIX_PLATFORM_CRC32C_HPP_
+#define TY_POSIX_PLATFORM_CRC32C_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ty {
+namespace Posix {
+
+/**
+ * Computes the CRC32C (Castagnoli) checksum of a buffer.
+ *
+ * Uses the CRC32 instructions of SSE 4.2 or ARMv8 if available and slicing-by-8 otherwise.
+ *
+ * @param[in]  aCrc     The checksum of the preceding data, 0 for the first buffer.
+ * @param[in]  aData    A pointer to the data.
+ * @param[in]  aLength  The length of the data.
+ *
+ * @returns The checksum of the preceding data and the buffer.
+ */
+uint32_t Crc32c(uint32_t aCrc, const void *aData, size_t aLength);
+
+} // namespace Posix
+} // namespace ty
+
+#endif // TY_POSIX_PLATFORM_CRC32C_HPP_
@@ -0,0 +1,118 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file
+ *   This file implements the content hash of shared setting values.
+ */
+
+#include <string.h>
+
+#include "hash64.hpp"
+
+namespace ty {
+namespace Posix {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9e3779b185ebca87;
+constexpr uint64_t kPrime2 = 0xc2b2ae3d27d4eb4f;
+constexpr uint64_t kPrime3 = 0x165667b19e3779f9;
+constexpr uint64_t kPrime4 = 0x85ebca77c2b2ae63;
+constexpr uint64_t kPrime5 = 0x27d4eb2f165667c5;
+
+uint64_t RotateLeft(uint64_t aValue, int aBits)
+{
+    return (aValue << aBits) | (aValue >> (64 - aBits));
+}
+
+uint64_t Read64(const uint8_t *aData)
+{
+    uint64_t value;
+
+    memcpy(&value, aData, sizeof(value));
+
+    return value;
+}
+
+uint32_t Read32(const uint8_t *aData)
+{
+    uint32_t value;
+
+    memcpy(&value, aData, sizeof(value));
+
+    return value;
+}
+
+uint64_t Round(uint64_t aAccumulator, uint64_t aInput)
+{
+    return RotateLeft(aAccumulator + aInput * kPrime2, 31) * kPrime1;
+}
+
+uint64_t MergeRound(uint64_t aHash, uint64_t aAccumulator)
+{
+    return (aHash ^ Round(0, aAccumulator)) * kPrime1 + kPrime4;
+}
+
+} // namespace
+
+uint64_t Hash64(const void *aData, size_t aLength, uint64_t aSeed)
+{
+    const uint8_t *data = static_cast<const uint8_t *>(aData);
+    const uint8_t *end  = data + aLength;
+    uint64_t       hash;
+
+    if (aLength >= 32)
+    {
+        uint64_t accumulators[4] = {aSeed + kPrime1 + kPrime2, aSeed + kPrime2, aSeed, aSeed - kPrime1};
+
+        for (; end - data >= 32; data += 32)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                accumulators[i] = Round(accumulators[i], Read64(data + 8 * i));
+            }
+        }
+
+        hash = RotateLeft(accumulators[0], 1) + RotateLeft(accumulators[1], 7) + RotateLeft(accumulators[2], 12) +
+               RotateLeft(accumulators[3], 18);
+
+        for (uint64_t accumulator : accumulators)
+        {
+            hash = MergeRound(hash, accumulator);
+        }
+    }
+    else
+    {
+        hash = aSeed + kPrime5;
+    }
+
+    hash += aLength;
+
+    for (; end - data >= 8; data += 8)
+    {
+        hash = RotateLeft(hash ^ Round(0, Read64(data)), 27) * kPrime1 + kPrime4;
+    }
+
+    if (end - data >= 4)
+    {
+        hash = RotateLeft(hash ^ (Read32(data) * kPrime1), 23) * kPrime2 + kPrime3;
+        data += 4;
+    }
+
+    for (; data < end; data++)
+    {
+        hash = RotateLeft(hash ^ (*data * kPrime5), 11) * kPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+} // namespace Posix
+} // namespace ty
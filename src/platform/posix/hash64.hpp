@@ -0,0 +1,27 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef TY_POSIX_PLATFORM_HASH64_HPP_
+#define TY_POSIX_PLATFORM_HASH64_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ty {
+namespace Posix {
+
+/**
+ * Computes the 64-bit XXH64 hash of a buffer.
+ *
+ * @param[in]  aData    A pointer to the data.
+ * @param[in]  aLength  The length of the data.
+ * @param[in]  aSeed    The seed of the hash.
+ *
+ * @returns The hash of the buffer.
+ */
+uint64_t Hash64(const void *aData, size_t aLength, uint64_t aSeed);
+
+} // namespace Posix
+} // namespace ty
+
+#endif // TY_POSIX_PLATFORM_HASH64_HPP_
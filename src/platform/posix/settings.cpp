@@ -14,6 +14,12 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <bitset>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
 #include <ty/common/debug.hpp>
 #include <ty/exit_code.h>
 #include <ty/logging.h>
@@ -21,53 +27,284 @@
 // #include <ty/platform/radio.h>
 
 #include <tysettings/platform/settings.h>
-#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-#include <ty/platform/secure_settings.h>
-#endif
 
+#include "async_persister.hpp"
 #include "settings.hpp"
 #include "settings_file.hpp"
+#include "settings_stats.hpp"
 #include "ty/common/code_utils.hpp"
 // #include "ty/common/encoding.hpp"
 
 // #include "system.hpp"
 
-static ty::Posix::SettingsFile sSettingsFile;
+static constexpr unsigned kShards = TYSETTINGS_POSIX_CONFIG_SHARDS;
+#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
+static constexpr unsigned kFiles = kShards + 1; ///< The shards followed by the secure store of the sensitive keys.
+#else
+static constexpr unsigned kFiles = kShards;
+#endif
+static constexpr size_t kShardSuffixLength = 3; ///< The length of the `.<shard>` or `.s` suffix of a file base name.
+static constexpr size_t kMaxBaseNameSize   = ty::Posix::SettingsFile::kMaxFileBaseNameSize - kShardSuffixLength;
 
+/**
+ * Holds the settings store of one instance.
+ *
+ * Entries are claimed and released under `sInstancesLock`, lookups only read `mState` and `mInstance`. Calls for
+ * different instances thus never wait on each other.
+ */
+struct InstanceSettings
+{
+    enum State : uint8_t
+    {
+        kStateFree,    ///< The entry is not used by any instance.
+        kStateClaimed, ///< The entry is used by `mInstance`.
+    };
+
+    std::atomic<uint8_t>        mState{kStateFree};
+    std::atomic<tinyInstance *> mInstance{nullptr};
+    bool                        mInitialized; ///< Whether `mFiles` are initialized, changed under `sInstancesLock`.
+    char                        mBaseName[kMaxBaseNameSize]; ///< Empty for the default.
+    ty::Posix::SettingsFile     mFiles[kFiles]; ///< The shards, followed by the secure store if enabled.
+    ty::Posix::AsyncPersister   mPersister;
+    std::shared_mutex           mBatchLock; ///< Held exclusively while a batch is committed to the files.
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+    ty::Posix::SettingsStats mStats;
+#endif
 #if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-static const uint16_t *sSensitiveKeys       = nullptr;
-static uint16_t        sSensitiveKeysLength = 0;
+    const uint16_t             *mSensitiveKeys;
+    uint16_t                    mSensitiveKeysLength;
+    std::bitset<UINT16_MAX + 1> mSensitiveKeyMap; ///< Whether a key is one of `mSensitiveKeys`.
+#endif
+};
+
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+/**
+ * Measures the rest of the calling function as a call of @p aOperation.
+ */
+#define SETTINGS_MEASURE(aInstance, aOperation) \
+    ty::Posix::SettingsStats::Timer statsTimer(getInstanceSettings(aInstance).mStats, aOperation)
+#else
+#define SETTINGS_MEASURE(aInstance, aOperation)
+#endif
+
+static InstanceSettings sInstanceSettings[TYSETTINGS_POSIX_CONFIG_MAX_INSTANCES];
+static std::mutex       sInstancesLock;
+
+static InstanceSettings *findInstanceSettings(tinyInstance *aInstance)
+{
+    InstanceSettings *found = nullptr;
+
+    for (InstanceSettings &settings : sInstanceSettings)
+    {
+        if (settings.mState.load(std::memory_order_acquire) == InstanceSettings::kStateClaimed &&
+            settings.mInstance.load(std::memory_order_relaxed) == aInstance)
+        {
+            found = &settings;
+            break;
+        }
+    }
 
-static bool isSensitiveKey(uint16_t aKey)
+    return found;
+}
+
+/**
+ * Returns the entry of @p aInstance, claiming a free one if there is none yet.
+ *
+ * Must be called with `sInstancesLock` held. Returns `nullptr` if all entries are used.
+ */
+static InstanceSettings *claimInstanceSettings(tinyInstance *aInstance)
 {
-    bool ret = false;
+    InstanceSettings *found = findInstanceSettings(aInstance);
 
-    VerifyOrExit(sSensitiveKeys != nullptr);
+    VerifyOrExit(found == nullptr);
 
-    for (uint16_t i = 0; i < sSensitiveKeysLength; i++)
+    for (InstanceSettings &settings : sInstanceSettings)
     {
-        VerifyOrExit(aKey != sSensitiveKeys[i], ret = true);
+        if (settings.mState.load(std::memory_order_relaxed) == InstanceSettings::kStateFree)
+        {
+            settings.mInitialized = false;
+            settings.mBaseName[0] = '\0';
+            settings.mInstance.store(aInstance, std::memory_order_relaxed);
+            settings.mState.store(InstanceSettings::kStateClaimed, std::memory_order_release);
+            found = &settings;
+            break;
+        }
     }
 
 exit:
-    return ret;
+    return found;
 }
+
+static InstanceSettings &getInstanceSettings(tinyInstance *aInstance)
+{
+    InstanceSettings *settings = findInstanceSettings(aInstance);
+
+    VerifyOrDie(settings != nullptr && settings->mInitialized, TY_EXIT_FAILURE);
+
+    return *settings;
+}
+
+/**
+ * Returns the shard of @p aKey, vendor-specific keys are kept apart from all other keys.
+ */
+static unsigned getShard(uint16_t aKey)
+{
+#if TYSETTINGS_POSIX_CONFIG_SHARDS > 1
+    return aKey >= TY_SETTINGS_KEY_VENDOR_RESERVED_MIN ? kShards - 1 : aKey % (kShards - 1);
+#else
+    TY_UNUSED_VARIABLE(aKey);
+
+    return 0;
 #endif
+}
+
+/**
+ * Returns the file of @p aKey, the secure store for sensitive keys and the shard of the key otherwise.
+ */
+static unsigned getFileIndex(const InstanceSettings &aSettings, uint16_t aKey)
+{
+    unsigned index = getShard(aKey);
+
+#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
+    if (aSettings.mSensitiveKeyMap.test(aKey))
+    {
+        index = kShards;
+    }
+#else
+    TY_UNUSED_VARIABLE(aSettings);
+#endif
+
+    return index;
+}
+
+static ty::Posix::SettingsFile &getSettingsFile(tinyInstance *aInstance, uint16_t aKey)
+{
+    InstanceSettings &settings = getInstanceSettings(aInstance);
+
+    return settings.mFiles[getFileIndex(settings, aKey)];
+}
+
+/**
+ * Moves the values of keys found in another file than their own, e.g. after the number of shards or the sensitive keys
+ * changed.
+ *
+ * The values are written to their file before they are deleted from the other one. Should that be interrupted, the
+ * values left in the other file replace the ones in their file on the next initialization.
+ */
+static void moveForeignKeys(InstanceSettings &aSettings)
+{
+    std::vector<uint8_t> value;
+
+    for (ty::Posix::SettingsFile &file : aSettings.mFiles)
+    {
+        uint32_t key = 0;
+        uint16_t foundKey;
+
+        for (; key <= UINT16_MAX && file.GetNextKey(static_cast<uint16_t>(key), foundKey) == TY_ERROR_NONE;
+             key = foundKey + 1u)
+        {
+            ty::Posix::SettingsFile &target = aSettings.mFiles[getFileIndex(aSettings, foundKey)];
+
+            if (&target == &file)
+            {
+                continue;
+            }
+
+            value.resize(UINT16_MAX);
+            VerifyOrDie(target.BeginBatch() == TY_ERROR_NONE, TY_EXIT_FAILURE);
+            target.Delete(foundKey, -1);
+
+            for (int index = 0;; index++)
+            {
+                uint16_t  length = static_cast<uint16_t>(value.size());
+                tinyError error  = file.Get(foundKey, index, value.data(), &length);
+
+                VerifyOrDie(error != TY_ERROR_PARSE, TY_EXIT_FAILURE);
+
+                if (error == TY_ERROR_NOT_FOUND)
+                {
+                    break;
+                }
+
+                target.Add(foundKey, value.data(), length);
+            }
+
+            VerifyOrDie(target.CommitBatch() == TY_ERROR_NONE && target.Flush() == TY_ERROR_NONE, TY_EXIT_FAILURE);
+            file.Delete(foundKey, -1);
+        }
+    }
+}
+
+static tinyError settingsFileInit(InstanceSettings &aSettings)
+{
+    tinyError error = TY_ERROR_NONE;
+
+    if (aSettings.mBaseName[0] == '\0')
+    {
+        const char *offset = getenv("PORT_OFFSET");
+        uint64_t    nodeId;
+
+        // tyPlatRadioGetIeeeEui64(aInstance, reinterpret_cast<uint8_t *>(&nodeId));
+        // nodeId = ty::BigEndian::HostSwap64(nodeId);
+        nodeId = 0x1234567890abcdef;
+        snprintf(aSettings.mBaseName, sizeof(aSettings.mBaseName), "%s_%" PRIx64, offset == nullptr ? "0" : offset,
+                 nodeId);
+        VerifyOrDie(strlen(aSettings.mBaseName) < sizeof(aSettings.mBaseName) - 1, TY_EXIT_FAILURE);
+    }
+
+    for (const InstanceSettings &other : sInstanceSettings)
+    {
+        // Two stores writing the same file would drop each other's changes.
+        VerifyOrDie(&other == &aSettings || !other.mInitialized || strcmp(other.mBaseName, aSettings.mBaseName) != 0,
+                    TY_EXIT_FAILURE);
+    }
+
+    for (unsigned index = 0; index < kFiles; index++)
+    {
+        char fileBaseName[ty::Posix::SettingsFile::kMaxFileBaseNameSize];
+
+        if (index == 0)
+        {
+            snprintf(fileBaseName, sizeof(fileBaseName), "%s", aSettings.mBaseName);
+        }
+        else if (index == kShards)
+        {
+            snprintf(fileBaseName, sizeof(fileBaseName), "%s.s", aSettings.mBaseName);
+        }
+        else
+        {
+            snprintf(fileBaseName, sizeof(fileBaseName), "%s.%u", aSettings.mBaseName, index);
+        }
+
+        SuccessOrExit(error = aSettings.mFiles[index].Init(fileBaseName, index == kShards));
+    }
+
+    moveForeignKeys(aSettings);
+
+exit:
+    return error;
+}
 
-static tinyError settingsFileInit(tinyInstance *aInstance)
+tinyError tyPlatSettingsSetBaseName(tinyInstance *aInstance, const char *aBaseName)
 {
-    static constexpr size_t kMaxFileBaseNameSize = 32;
-    char                    fileBaseName[kMaxFileBaseNameSize];
-    const char             *offset = getenv("PORT_OFFSET");
-    uint64_t                nodeId;
+    std::lock_guard<std::mutex> lock(sInstancesLock);
+    tinyError                   error = TY_ERROR_NONE;
+    InstanceSettings           *settings;
 
-    // tyPlatRadioGetIeeeEui64(aInstance, reinterpret_cast<uint8_t *>(&nodeId));
-    // nodeId = ty::BigEndian::HostSwap64(nodeId);
-    nodeId = 0x1234567890abcdef;
-    snprintf(fileBaseName, sizeof(fileBaseName), "%s_%" PRIx64, offset == nullptr ? "0" : offset, nodeId);
-    VerifyOrDie(strlen(fileBaseName) < kMaxFileBaseNameSize, TY_EXIT_FAILURE);
+    VerifyOrExit(aBaseName != nullptr && aBaseName[0] != '\0' && strchr(aBaseName, '/') == nullptr,
+                 error = TY_ERROR_INVALID_ARGS);
+    VerifyOrExit(strlen(aBaseName) < kMaxBaseNameSize, error = TY_ERROR_INVALID_ARGS);
+    // The base names of the shards and the secure store must not collide with the base name of another instance.
+    VerifyOrExit(kFiles == 1 || strchr(aBaseName, '.') == nullptr, error = TY_ERROR_INVALID_ARGS);
 
-    return sSettingsFile.Init(fileBaseName);
+    settings = claimInstanceSettings(aInstance);
+    VerifyOrExit(settings != nullptr, error = TY_ERROR_NO_BUFS);
+    VerifyOrExit(!settings->mInitialized, error = TY_ERROR_INVALID_STATE);
+
+    strcpy(settings->mBaseName, aBaseName);
+
+exit:
+    return error;
 }
 
 void tyPlatSettingsInit(tinyInstance *aInstance, const uint16_t *aSensitiveKeys, uint16_t aSensitiveKeysLength)
@@ -77,18 +314,40 @@ void tyPlatSettingsInit(tinyInstance *aInstance, const uint16_t *aSensitiveKeys,
     TY_UNUSED_VARIABLE(aSensitiveKeysLength);
 #endif
 
-#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-    sSensitiveKeys       = aSensitiveKeys;
-    sSensitiveKeysLength = aSensitiveKeysLength;
-#endif
+    {
+        std::lock_guard<std::mutex> lock(sInstancesLock);
+        InstanceSettings           *settings = claimInstanceSettings(aInstance);
 
-    // Don't touch the settings file the system runs in dry-run mode.
-    // VerifyOrExit(!IsSystemDryRun());
-    SuccessOrExit(settingsFileInit(aInstance));
+        VerifyOrDie(settings != nullptr, TY_EXIT_FAILURE);
+        VerifyOrDie(!settings->mInitialized, TY_EXIT_FAILURE);
 
 #if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-    otPosixSecureSettingsInit(aInstance);
+        settings->mSensitiveKeys       = aSensitiveKeys;
+        settings->mSensitiveKeysLength = aSensitiveKeysLength;
+        settings->mSensitiveKeyMap.reset();
+
+        for (uint16_t i = 0; aSensitiveKeys != nullptr && i < aSensitiveKeysLength; i++)
+        {
+            settings->mSensitiveKeyMap.set(aSensitiveKeys[i]);
+        }
+#endif
+
+        // Don't touch the settings file the system runs in dry-run mode.
+        // VerifyOrExit(!IsSystemDryRun());
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+        settings->mStats.Reset();
+#endif
+        SuccessOrExit(settingsFileInit(*settings));
+        settings->mPersister.Init();
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE && TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL > 0
+        // The helper thread writes changes held back for the interval when no further change does.
+        for (ty::Posix::SettingsFile &file : settings->mFiles)
+        {
+            file.SetWriteBackHandler(ty::Posix::AsyncPersister::HandleWriteBack, &settings->mPersister);
+        }
 #endif
+        settings->mInitialized = true;
+    }
 
 exit:
     return;
@@ -96,15 +355,31 @@ exit:
 
 void tyPlatSettingsDeinit(tinyInstance *aInstance)
 {
-    TY_UNUSED_VARIABLE(aInstance);
+    InstanceSettings *settings = findInstanceSettings(aInstance);
 
     // VerifyOrExit(!IsSystemDryRun());
+    VerifyOrExit(settings != nullptr && settings->mInitialized);
 
-#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-    otPosixSecureSettingsDeinit(aInstance);
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE && TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL > 0
+    for (ty::Posix::SettingsFile &file : settings->mFiles)
+    {
+        file.SetWriteBackHandler(nullptr, nullptr);
+    }
 #endif
 
-    sSettingsFile.Deinit();
+    settings->mPersister.Deinit(aInstance);
+
+    for (ty::Posix::SettingsFile &file : settings->mFiles)
+    {
+        file.Deinit();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sInstancesLock);
+
+        settings->mInitialized = false;
+        settings->mState.store(InstanceSettings::kStateFree, std::memory_order_release);
+    }
 
 exit:
     return;
@@ -112,114 +387,505 @@ exit:
 
 tinyError tyPlatSettingsGet(tinyInstance *aInstance, uint16_t aKey, int aIndex, uint8_t *aValue, uint16_t *aValueLength)
 {
-    TY_UNUSED_VARIABLE(aInstance);
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_GET);
 
     tinyError error = TY_ERROR_NOT_FOUND;
 
     // VerifyOrExit(!IsSystemDryRun());
-#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-    if (isSensitiveKey(aKey))
+    error = getSettingsFile(aInstance, aKey).Get(aKey, aIndex, aValue, aValueLength);
+
+exit:
+    VerifyOrDie(error != TY_ERROR_PARSE, TY_EXIT_FAILURE);
+    return error;
+}
+
+tinyError tyPlatSettingsGetMany(tinyInstance *aInstance, const tyPlatSettingsRequest *aRequests, size_t aCount)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_GET);
+
+    InstanceSettings                          &settings = getInstanceSettings(aInstance);
+    std::vector<const tyPlatSettingsRequest *> fileRequests[kFiles];
+    tinyError                                  error = TY_ERROR_NONE;
+
+    for (size_t i = 0; i < aCount; i++)
     {
-        error = otPosixSecureSettingsGet(aInstance, aKey, aIndex, aValue, aValueLength);
+        fileRequests[getFileIndex(settings, aRequests[i].mKey)].push_back(&aRequests[i]);
     }
-    else
-#endif
+
+    for (unsigned index = 0; index < kFiles; index++)
     {
-        error = sSettingsFile.Get(aKey, aIndex, aValue, aValueLength);
+        tinyError fileError;
+
+        if (fileRequests[index].empty())
+        {
+            continue;
+        }
+
+        fileError = settings.mFiles[index].GetMany(fileRequests[index].data(), fileRequests[index].size());
+        VerifyOrDie(fileError != TY_ERROR_PARSE, TY_EXIT_FAILURE);
+
+        if (fileError != TY_ERROR_NONE)
+        {
+            error = fileError;
+        }
     }
 
-exit:
-    VerifyOrDie(error != TY_ERROR_PARSE, TY_EXIT_FAILURE);
     return error;
 }
 
-tinyError tyPlatSettingsSet(tinyInstance *aInstance, uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
+tinyError tyPlatSettingsGetView(tinyInstance   *aInstance,
+                                uint16_t        aKey,
+                                int             aIndex,
+                                const uint8_t **aData,
+                                uint16_t       *aLength)
 {
-    TY_UNUSED_VARIABLE(aInstance);
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_GET);
 
+    return getSettingsFile(aInstance, aKey).GetView(aKey, aIndex, aData, aLength);
+}
+
+tinyError tyPlatSettingsIterBegin(tinyInstance *aInstance, tyPlatSettingsIter *aIter, int32_t aKey)
+{
     tinyError error = TY_ERROR_NONE;
 
-#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-    if (isSensitiveKey(aKey))
+    VerifyOrExit(aKey >= -1 && aKey <= UINT16_MAX, error = TY_ERROR_INVALID_ARGS);
+
+    aIter->mKey       = aKey;
+    aIter->mNextKey   = (aKey == -1) ? 0 : static_cast<uint16_t>(aKey);
+    aIter->mNextIndex = 0;
+    // The file to continue in, the values of a single key are all in the same file.
+    aIter->mPosition = (aKey == -1) ? 0 : getFileIndex(getInstanceSettings(aInstance), aIter->mNextKey);
+    aIter->mContext  = nullptr;
+
+exit:
+    return error;
+}
+
+tinyError tyPlatSettingsIterNext(tinyInstance       *aInstance,
+                                 tyPlatSettingsIter *aIter,
+                                 uint16_t           *aKey,
+                                 uint8_t            *aValue,
+                                 uint16_t           *aValueLength)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_GET);
+
+    InstanceSettings &settings = getInstanceSettings(aInstance);
+    tinyError         error    = TY_ERROR_NOT_FOUND;
+    bool              allKeys  = (aIter->mKey == -1);
+
+    // Sensitive settings are only returned when iterating their key, iterating all keys skips the secure store.
+    while (aIter->mPosition < (allKeys ? kShards : kFiles))
     {
-        error = otPosixSecureSettingsSet(aInstance, aKey, aValue, aValueLength);
+        uint16_t key   = aIter->mNextKey;
+        int      index = aIter->mNextIndex;
+
+        error = settings.mFiles[aIter->mPosition].GetNext(key, index, allKeys, aValue, aValueLength);
+        VerifyOrDie(error != TY_ERROR_PARSE, TY_EXIT_FAILURE);
+
+        if (error == TY_ERROR_NONE)
+        {
+            aIter->mNextKey   = key;
+            aIter->mNextIndex = index + 1;
+            break;
+        }
+
+        // The file is exhausted, a single key has no values in other files.
+        aIter->mPosition  = allKeys ? aIter->mPosition + 1 : kFiles;
+        aIter->mNextKey   = 0;
+        aIter->mNextIndex = 0;
     }
-    else
-#endif
+
+    if (error == TY_ERROR_NONE && aKey != nullptr)
     {
-        sSettingsFile.Set(aKey, aValue, aValueLength);
+        *aKey = aIter->mNextKey;
     }
 
     return error;
 }
 
-tinyError tyPlatSettingsAdd(tinyInstance *aInstance, uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
+void tyPlatSettingsIterEnd(tinyInstance *aInstance, tyPlatSettingsIter *aIter)
 {
     TY_UNUSED_VARIABLE(aInstance);
 
-    tinyError error = TY_ERROR_NONE;
+    // Iterations hold no resources, the position is kept in the iteration itself.
+    aIter->mPosition = kFiles;
+}
 
-#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-    if (isSensitiveKey(aKey))
+tinyError tyPlatSettingsForEach(tinyInstance                 *aInstance,
+                                int32_t                       aKey,
+                                tyPlatSettingsForEachCallback aCallback,
+                                void                         *aContext)
+{
+    tinyError            error;
+    tyPlatSettingsIter   iter;
+    std::vector<uint8_t> value(UINT16_MAX);
+    uint16_t             key;
+    uint16_t             length;
+
+    // The iteration continues in the in-memory index, a walk costs no more than iterating.
+    SuccessOrExit(error = tyPlatSettingsIterBegin(aInstance, &iter, aKey));
+
+    do
     {
-        error = otPosixSecureSettingsAdd(aInstance, aKey, aValue, aValueLength);
+        length = static_cast<uint16_t>(value.size());
+    } while (tyPlatSettingsIterNext(aInstance, &iter, &key, value.data(), &length) == TY_ERROR_NONE &&
+             aCallback(aInstance, key, value.data(), length, aContext));
+
+    tyPlatSettingsIterEnd(aInstance, &iter);
+
+exit:
+    return error;
+}
+
+tinyError tyPlatSettingsSet(tinyInstance *aInstance, uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_SET);
+
+    getSettingsFile(aInstance, aKey).Set(aKey, aValue, aValueLength);
+
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsAdd(tinyInstance *aInstance, uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_ADD);
+
+    getSettingsFile(aInstance, aKey).Add(aKey, aValue, aValueLength);
+
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsDelete(tinyInstance *aInstance, uint16_t aKey, int aIndex)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_DELETE);
+
+    return getSettingsFile(aInstance, aKey).Delete(aKey, aIndex);
+}
+
+tinyError tyPlatSettingsAddWithHandle(tinyInstance         *aInstance,
+                                      uint16_t              aKey,
+                                      const uint8_t        *aValue,
+                                      uint16_t              aValueLength,
+                                      tyPlatSettingsHandle *aHandle)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_ADD);
+
+    uint32_t id = getSettingsFile(aInstance, aKey).Add(aKey, aValue, aValueLength);
+
+    if (aHandle != nullptr)
+    {
+        // The key selects the settings file and the records of the key, the identifier the record among them.
+        *aHandle = (static_cast<tyPlatSettingsHandle>(aKey) << 32) | id;
     }
-    else
-#endif
+
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsGetByHandle(tinyInstance        *aInstance,
+                                    tyPlatSettingsHandle aHandle,
+                                    uint8_t             *aValue,
+                                    uint16_t            *aValueLength)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_GET);
+
+    uint16_t  key   = static_cast<uint16_t>(aHandle >> 32);
+    tinyError error = TY_ERROR_NOT_FOUND;
+
+    VerifyOrExit((aHandle >> 48) == 0);
+
+    error = getSettingsFile(aInstance, key).GetById(key, static_cast<uint32_t>(aHandle), aValue, aValueLength);
+    VerifyOrDie(error != TY_ERROR_PARSE, TY_EXIT_FAILURE);
+
+exit:
+    return error;
+}
+
+tinyError tyPlatSettingsDeleteByHandle(tinyInstance *aInstance, tyPlatSettingsHandle aHandle)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_DELETE);
+
+    uint16_t  key   = static_cast<uint16_t>(aHandle >> 32);
+    tinyError error = TY_ERROR_NOT_FOUND;
+
+    VerifyOrExit((aHandle >> 48) == 0);
+
+    error = getSettingsFile(aInstance, key).DeleteById(key, static_cast<uint32_t>(aHandle));
+
+exit:
+    return error;
+}
+
+void tyPlatSettingsWipe(tinyInstance *aInstance)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_WIPE);
+
+    for (ty::Posix::SettingsFile &file : getInstanceSettings(aInstance).mFiles)
     {
-        sSettingsFile.Add(aKey, aValue, aValueLength);
+        file.Wipe();
+    }
+}
+
+tinyError tyPlatSettingsFlush(tinyInstance *aInstance)
+{
+    tinyError error = TY_ERROR_NONE;
+
+    for (ty::Posix::SettingsFile &file : getInstanceSettings(aInstance).mFiles)
+    {
+        tinyError shardError = file.Flush();
+
+        if (error == TY_ERROR_NONE)
+        {
+            error = shardError;
+        }
     }
 
     return error;
 }
 
-tinyError tyPlatSettingsDelete(tinyInstance *aInstance, uint16_t aKey, int aIndex)
+tinyError tyPlatSettingsBeginBatch(tinyInstance *aInstance)
 {
-    TY_UNUSED_VARIABLE(aInstance);
+    InstanceSettings &settings = getInstanceSettings(aInstance);
+    tinyError         error    = TY_ERROR_NONE;
+
+    for (unsigned index = 0; index < kFiles; index++)
+    {
+        error = settings.mFiles[index].BeginBatch();
+
+        if (error != TY_ERROR_NONE)
+        {
+            // Either all files have an active batch or none.
+            while (index-- > 0)
+            {
+                settings.mFiles[index].AbortBatch();
+            }
+
+            break;
+        }
+    }
 
-    tinyError error;
+    return error;
+}
 
-#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-    if (isSensitiveKey(aKey))
+tinyError tyPlatSettingsCommitBatch(tinyInstance *aInstance)
+{
+    InstanceSettings                   &settings = getInstanceSettings(aInstance);
+    std::lock_guard<std::shared_mutex> batchLock(settings.mBatchLock);
+    tinyError                          error = TY_ERROR_NONE;
+
+    for (ty::Posix::SettingsFile &file : settings.mFiles)
     {
-        error = otPosixSecureSettingsDelete(aInstance, aKey, aIndex);
+        tinyError shardError = file.CommitBatch();
+
+        if (error == TY_ERROR_NONE)
+        {
+            error = shardError;
+        }
     }
-    else
-#endif
+
+    return error;
+}
+
+tinyError tyPlatSettingsAbortBatch(tinyInstance *aInstance)
+{
+    tinyError error = TY_ERROR_NONE;
+
+    for (ty::Posix::SettingsFile &file : getInstanceSettings(aInstance).mFiles)
     {
-        error = sSettingsFile.Delete(aKey, aIndex);
+        tinyError shardError = file.AbortBatch();
+
+        if (error == TY_ERROR_NONE)
+        {
+            error = shardError;
+        }
     }
 
     return error;
 }
 
-void tyPlatSettingsWipe(tinyInstance *aInstance)
+tinyError tyPlatSettingsSetAsync(tinyInstance          *aInstance,
+                                 uint16_t               aKey,
+                                 const uint8_t         *aValue,
+                                 uint16_t               aValueLength,
+                                 tyPlatSettingsCallback aCallback,
+                                 void                  *aContext)
 {
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_SET);
+
+    InstanceSettings        &settings = getInstanceSettings(aInstance);
+    ty::Posix::SettingsFile &file     = settings.mFiles[getFileIndex(settings, aKey)];
+    tinyError                error    = TY_ERROR_NONE;
+    uint64_t                 change   = 0;
+
+    SuccessOrExit(error = file.SetAsync(aKey, aValue, aValueLength, change));
+    settings.mPersister.Submit(file, change, aCallback, aContext);
+
+exit:
+    return error;
+}
+
+tinyError tyPlatSettingsAddAsync(tinyInstance          *aInstance,
+                                 uint16_t               aKey,
+                                 const uint8_t         *aValue,
+                                 uint16_t               aValueLength,
+                                 tyPlatSettingsCallback aCallback,
+                                 void                  *aContext)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_ADD);
+
+    InstanceSettings        &settings = getInstanceSettings(aInstance);
+    ty::Posix::SettingsFile &file     = settings.mFiles[getFileIndex(settings, aKey)];
+    tinyError                error    = TY_ERROR_NONE;
+    uint64_t                 change   = 0;
+
+    SuccessOrExit(error = file.AddAsync(aKey, aValue, aValueLength, change));
+    settings.mPersister.Submit(file, change, aCallback, aContext);
+
+exit:
+    return error;
+}
+
+tinyError tyPlatSettingsDeleteAsync(tinyInstance          *aInstance,
+                                    uint16_t               aKey,
+                                    int                    aIndex,
+                                    tyPlatSettingsCallback aCallback,
+                                    void                  *aContext)
+{
+    SETTINGS_MEASURE(aInstance, TY_PLAT_SETTINGS_OPERATION_DELETE);
+
+    InstanceSettings        &settings = getInstanceSettings(aInstance);
+    ty::Posix::SettingsFile &file     = settings.mFiles[getFileIndex(settings, aKey)];
+    tinyError                error    = TY_ERROR_NONE;
+    uint64_t                 change   = 0;
+
+    SuccessOrExit(error = file.DeleteAsync(aKey, aIndex, change));
+    settings.mPersister.Submit(file, change, aCallback, aContext);
+
+exit:
+    return error;
+}
+
+tinyError tyPlatSettingsGetStats(tinyInstance *aInstance, tyPlatSettingsStats *aStats)
+{
+    tinyError error = TY_ERROR_NONE;
+
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+    InstanceSettings &settings = getInstanceSettings(aInstance);
+
+    memset(aStats, 0, sizeof(*aStats));
+    settings.mStats.Get(*aStats);
+
+    for (const ty::Posix::SettingsFile &file : settings.mFiles)
+    {
+        file.GetStats(*aStats);
+    }
+#else
     TY_UNUSED_VARIABLE(aInstance);
-#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
-    otPosixSecureSettingsWipe(aInstance);
+    TY_UNUSED_VARIABLE(aStats);
+
+    error = TY_ERROR_NOT_IMPLEMENTED;
 #endif
 
-    sSettingsFile.Wipe();
+    return error;
+}
+
+int tyPlatSettingsGetEventFd(tinyInstance *aInstance)
+{
+    return getInstanceSettings(aInstance).mPersister.GetEventFd();
+}
+
+void tyPlatSettingsProcess(tinyInstance *aInstance)
+{
+    getInstanceSettings(aInstance).mPersister.Process(aInstance);
+}
+
+tinyError tyPlatSettingsSnapshot(tinyInstance *aInstance, int aFd)
+{
+    InstanceSettings                 &settings = getInstanceSettings(aInstance);
+    ty::Posix::SettingsFile::ImagePin pins[kShards];
+    tinyError                         error = TY_ERROR_NONE;
+
+    {
+        // A batch is not committed to some shards only while they are pinned.
+        std::shared_lock<std::shared_mutex> batchLock(settings.mBatchLock);
+
+        ty::Posix::SettingsFile::PinImages(settings.mFiles, kShards, pins);
+    }
+
+    // The shards hold disjoint keys, their entries are appended to one image behind the header of the first. Sensitive
+    // settings do not leave the secure store. Each pin is released by its copy.
+    for (unsigned shard = 0; shard < kShards; shard++)
+    {
+        tinyError shardError = settings.mFiles[shard].CopyImage(pins[shard], aFd, shard == 0);
+
+        if (error == TY_ERROR_NONE)
+        {
+            error = shardError;
+        }
+    }
+
+    return error;
+}
+
+tinyError tyPlatSettingsRestore(tinyInstance *aInstance, int aFd)
+{
+    InstanceSettings       &settings = getInstanceSettings(aInstance);
+    ty::Posix::SettingsFile image;
+    std::vector<uint8_t>    value(UINT16_MAX);
+    tinyError               error;
+    uint32_t                key = 0;
+    uint16_t                foundKey;
+
+    SuccessOrExit(error = image.LoadImage(aFd));
+
+    // Each shard is replaced by a single rewrite once all values are staged.
+    SuccessOrExit(error = tyPlatSettingsBeginBatch(aInstance));
+
+    for (unsigned shard = 0; shard < kShards; shard++)
+    {
+        settings.mFiles[shard].Wipe();
+    }
+
+    for (; key <= UINT16_MAX && image.GetNextKey(static_cast<uint16_t>(key), foundKey) == TY_ERROR_NONE;
+         key = foundKey + 1u)
+    {
+        ty::Posix::SettingsFile &file   = getSettingsFile(aInstance, foundKey);
+        uint16_t                 length = static_cast<uint16_t>(value.size());
+
+        // The secure store is kept, a key which became sensitive since the snapshot replaces its values there.
+        file.Delete(foundKey, -1);
+
+        for (int index = 0; image.Get(foundKey, index, value.data(), &length) == TY_ERROR_NONE; index++)
+        {
+            file.Add(foundKey, value.data(), length);
+            length = static_cast<uint16_t>(value.size());
+        }
+    }
+
+    SuccessOrExit(error = tyPlatSettingsCommitBatch(aInstance));
+    error = tyPlatSettingsFlush(aInstance);
+
+exit:
+    return error;
 }
 
-namespace ot {
+namespace ty {
 namespace Posix {
 #if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
 void PlatformSettingsGetSensitiveKeys(tinyInstance *aInstance, const uint16_t **aKeys, uint16_t *aKeysLength)
 {
-    TY_UNUSED_VARIABLE(aInstance);
+    InstanceSettings *settings = findInstanceSettings(aInstance);
 
     assert(aKeys != nullptr);
     assert(aKeysLength != nullptr);
+    assert(settings != nullptr);
 
-    *aKeys       = sSensitiveKeys;
-    *aKeysLength = sSensitiveKeysLength;
+    *aKeys       = settings->mSensitiveKeys;
+    *aKeysLength = settings->mSensitiveKeysLength;
 }
 #endif
 
 } // namespace Posix
-} // namespace ot
+} // namespace ty
 
 #ifndef SELF_TEST
 #define SELF_TEST 0
@@ -227,6 +893,11 @@ void PlatformSettingsGetSensitiveKeys(tinyInstance *aInstance, const uint16_t **
 
 #if SELF_TEST
 
+#include <poll.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 void otLogCritPlat(const char *aFormat, ...)
 {
     TY_UNUSED_VARIABLE(aFormat);
@@ -251,6 +922,48 @@ bool IsSystemDryRun(void)
     return false;
 }
 
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+static const char *const kBanks[] = {TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data",
+                                     TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.Swap"};
+
+typedef ty::Posix::SettingsFile::BankTrailer BankTrailer;
+
+static constexpr off_t kBankTrailerSize = ty::Posix::SettingsFile::kBankTrailerSize;
+
+// Returns the bank of the first shard with the latest generation.
+static const char *getLatestBank(uint64_t *aGeneration = nullptr, off_t *aEnd = nullptr)
+{
+    const off_t kGenerationOffset = static_cast<off_t>(offsetof(BankTrailer, mGeneration)) - kBankTrailerSize;
+    uint64_t    generation[2];
+    off_t       end[2];
+    int         latest;
+
+    for (int bank = 0; bank < 2; bank++)
+    {
+        int fd = open(kBanks[bank], O_RDONLY);
+
+        assert(fd >= 0);
+        end[bank] = lseek(fd, 0, SEEK_END);
+        assert(pread(fd, &generation[bank], sizeof(uint64_t), end[bank] + kGenerationOffset) == sizeof(uint64_t));
+        assert(close(fd) == 0);
+    }
+
+    latest = generation[1] > generation[0] ? 1 : 0;
+
+    if (aGeneration != nullptr)
+    {
+        *aGeneration = generation[latest];
+    }
+
+    if (aEnd != nullptr)
+    {
+        *aEnd = end[latest];
+    }
+
+    return kBanks[latest];
+}
+#endif
+
 int main()
 {
     tinyInstance *instance = nullptr;
@@ -341,6 +1054,253 @@ int main()
     }
     tyPlatSettingsWipe(instance);
 
+    // verify get many records
+    assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data) / 2) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 1, data, sizeof(data) / 3) == TY_ERROR_NONE);
+    assert(tyPlatSettingsSet(instance, 0x8001, data, sizeof(data) / 4) == TY_ERROR_NONE);
+    {
+        uint8_t               values[4][sizeof(data)];
+        uint16_t              lengths[4] = {sizeof(data), sizeof(data), sizeof(data), sizeof(data)};
+        uint16_t              length     = 0;
+        tinyError             errors[6];
+        tyPlatSettingsRequest requests[] = {
+            {0, 1, values[0], &lengths[0], &errors[0]}, {0x8001, 0, values[1], &lengths[1], &errors[1]},
+            {1, 0, values[2], &lengths[2], &errors[2]}, {0, 0, values[3], &lengths[3], &errors[3]},
+            {1, 1, nullptr, nullptr, &errors[4]},       {2, 0, nullptr, &length, &errors[5]},
+        };
+
+        assert(tyPlatSettingsGetMany(instance, requests, 4) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGetMany(instance, requests, 6) == TY_ERROR_NOT_FOUND);
+        assert(errors[0] == TY_ERROR_NONE && lengths[0] == sizeof(data) / 2);
+        assert(errors[1] == TY_ERROR_NONE && lengths[1] == sizeof(data) / 4);
+        assert(errors[2] == TY_ERROR_NONE && lengths[2] == sizeof(data) / 3);
+        assert(errors[3] == TY_ERROR_NONE && lengths[3] == sizeof(data));
+        assert(errors[4] == TY_ERROR_NOT_FOUND);
+        assert(errors[5] == TY_ERROR_NOT_FOUND);
+
+        for (size_t i = 0; i < 4; i++)
+        {
+            assert(0 == memcmp(values[i], data, lengths[i]));
+        }
+    }
+    tyPlatSettingsWipe(instance);
+
+    // verify handles of records
+    {
+        tyPlatSettingsHandle handles[3];
+        uint8_t              value[sizeof(data)];
+        uint16_t             length = sizeof(value);
+
+        assert(tyPlatSettingsAddWithHandle(instance, 0, data, sizeof(data), &handles[0]) == TY_ERROR_NONE);
+        assert(tyPlatSettingsAddWithHandle(instance, 0, data, sizeof(data) / 2, &handles[1]) == TY_ERROR_NONE);
+        assert(tyPlatSettingsAddWithHandle(instance, 0x8001, data, sizeof(data) / 3, &handles[2]) == TY_ERROR_NONE);
+        assert(tyPlatSettingsAddWithHandle(instance, 0, data, sizeof(data) / 4, nullptr) == TY_ERROR_NONE);
+
+        // the handle survives deleting values before it
+        assert(tyPlatSettingsDeleteByHandle(instance, handles[0]) == TY_ERROR_NONE);
+        assert(tyPlatSettingsDeleteByHandle(instance, handles[0]) == TY_ERROR_NOT_FOUND);
+        assert(tyPlatSettingsGetByHandle(instance, handles[0], nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+        assert(tyPlatSettingsGetByHandle(instance, handles[1], value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 2);
+        assert(0 == memcmp(value, data, length));
+        assert(tyPlatSettingsGetByHandle(instance, handles[2], nullptr, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 3);
+
+        // the handle of one key does not address values of another key
+        assert(tyPlatSettingsGetByHandle(instance, handles[1] + (1ull << 32), nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+        assert(tyPlatSettingsGetByHandle(instance, handles[1] | (1ull << 48), nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+
+        assert(tyPlatSettingsDeleteByHandle(instance, handles[1]) == TY_ERROR_NONE);
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 4);
+        assert(tyPlatSettingsGet(instance, 0, 1, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+
+        // handles stay valid when the settings are initialized again, values added later get new handles
+        tyPlatSettingsDeinit(instance);
+        tyPlatSettingsInit(instance, nullptr, 0);
+        length = sizeof(value);
+        assert(tyPlatSettingsGetByHandle(instance, handles[2], value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 3);
+        assert(0 == memcmp(value, data, length));
+        assert(tyPlatSettingsAddWithHandle(instance, 0, data, sizeof(data) / 5, &handles[0]) == TY_ERROR_NONE);
+        assert(handles[0] != handles[1]);
+        assert(tyPlatSettingsGetByHandle(instance, handles[1], nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+        assert(tyPlatSettingsDeleteByHandle(instance, handles[1]) == TY_ERROR_NOT_FOUND);
+        length = sizeof(value);
+        assert(tyPlatSettingsGetByHandle(instance, handles[0], value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 5);
+        assert(tyPlatSettingsGet(instance, 0, 1, nullptr, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 5);
+    }
+    tyPlatSettingsWipe(instance);
+
+    // verify statistics
+    {
+        tyPlatSettingsStats stats;
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+        uint8_t  value[sizeof(data)];
+        uint16_t length = sizeof(value);
+        uint64_t gets;
+        uint64_t sets;
+        uint64_t bytesRead;
+        uint64_t commits;
+        uint64_t histogram = 0;
+
+        assert(tyPlatSettingsGetStats(instance, &stats) == TY_ERROR_NONE);
+        gets      = stats.mOperations[TY_PLAT_SETTINGS_OPERATION_GET].mCount;
+        sets      = stats.mOperations[TY_PLAT_SETTINGS_OPERATION_SET].mCount;
+        bytesRead = stats.mBytesRead;
+        commits   = stats.mCommits;
+
+        assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+        assert(tyPlatSettingsFlush(instance) == TY_ERROR_NONE);
+
+        assert(tyPlatSettingsGetStats(instance, &stats) == TY_ERROR_NONE);
+        assert(stats.mOperations[TY_PLAT_SETTINGS_OPERATION_GET].mCount == gets + 1);
+        assert(stats.mOperations[TY_PLAT_SETTINGS_OPERATION_SET].mCount == sets + 1);
+        assert(stats.mBytesRead == bytesRead + sizeof(data));
+        assert(stats.mCommits > commits);
+        assert(stats.mBytesWritten >= sizeof(data));
+
+        for (uint64_t count : stats.mOperations[TY_PLAT_SETTINGS_OPERATION_SET].mLatency)
+        {
+            histogram += count;
+        }
+        assert(histogram == stats.mOperations[TY_PLAT_SETTINGS_OPERATION_SET].mCount);
+#else
+        assert(tyPlatSettingsGetStats(instance, &stats) == TY_ERROR_NOT_IMPLEMENTED);
+#endif
+    }
+    tyPlatSettingsWipe(instance);
+
+    // verify snapshot and restore
+    assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data) / 2) == TY_ERROR_NONE);
+    assert(tyPlatSettingsSet(instance, 0x8001, data, sizeof(data) / 3) == TY_ERROR_NONE);
+    {
+        FILE    *image = tmpfile();
+        uint8_t  value[sizeof(data)];
+        uint16_t length = sizeof(value);
+        off_t    size;
+
+        assert(image != nullptr);
+        assert(tyPlatSettingsSnapshot(instance, fileno(image)) == TY_ERROR_NONE);
+        size = lseek(fileno(image), 0, SEEK_CUR);
+        assert(size > 0);
+
+        tyPlatSettingsWipe(instance);
+        assert(tyPlatSettingsSet(instance, 1, data, sizeof(data)) == TY_ERROR_NONE);
+
+        // a batch is replaced by a restore
+        assert(tyPlatSettingsBeginBatch(instance) == TY_ERROR_NONE);
+        assert(tyPlatSettingsRestore(instance, fileno(image)) == TY_ERROR_INVALID_STATE);
+        assert(tyPlatSettingsAbortBatch(instance) == TY_ERROR_NONE);
+
+        assert(tyPlatSettingsRestore(instance, fileno(image)) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) && 0 == memcmp(value, data, length));
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 0, 1, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 2);
+        assert(tyPlatSettingsGet(instance, 0, 2, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 0x8001, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 3);
+        assert(tyPlatSettingsGet(instance, 1, 0, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+
+        // the restore is persisted
+        tyPlatSettingsDeinit(instance);
+        tyPlatSettingsInit(instance, nullptr, 0);
+        assert(tyPlatSettingsGet(instance, 0, 1, nullptr, nullptr) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGet(instance, 0x8001, 0, nullptr, nullptr) == TY_ERROR_NONE);
+
+        // a torn image changes nothing
+        tyPlatSettingsWipe(instance);
+        assert(tyPlatSettingsSet(instance, 1, data, sizeof(data)) == TY_ERROR_NONE);
+        assert(ftruncate(fileno(image), size - 1) == 0);
+        assert(tyPlatSettingsRestore(instance, fileno(image)) == TY_ERROR_PARSE);
+        assert(tyPlatSettingsGet(instance, 1, 0, nullptr, nullptr) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGet(instance, 0, 0, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+
+        fclose(image);
+    }
+    tyPlatSettingsWipe(instance);
+
+    // verify iterate records
+    assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data) / 2) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data) / 3) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 1, data, sizeof(data) / 4) == TY_ERROR_NONE);
+    assert(tyPlatSettingsSet(instance, 0x8001, data, sizeof(data) / 5) == TY_ERROR_NONE);
+    {
+        tyPlatSettingsIter iter;
+        uint8_t            value[sizeof(data)];
+        uint16_t           length;
+        uint16_t           key;
+        size_t             counts[3] = {0, 0, 0};
+
+        assert(tyPlatSettingsIterBegin(instance, &iter, -2) == TY_ERROR_INVALID_ARGS);
+        assert(tyPlatSettingsIterBegin(instance, &iter, UINT16_MAX + 1) == TY_ERROR_INVALID_ARGS);
+
+        assert(tyPlatSettingsIterBegin(instance, &iter, 0) == TY_ERROR_NONE);
+        for (uint16_t divisor = 1; divisor <= 3; divisor++)
+        {
+            length = sizeof(value);
+            assert(tyPlatSettingsIterNext(instance, &iter, &key, value, &length) == TY_ERROR_NONE);
+            assert(key == 0 && length == sizeof(data) / divisor);
+            assert(0 == memcmp(value, data, length));
+        }
+        assert(tyPlatSettingsIterNext(instance, &iter, &key, value, &length) == TY_ERROR_NOT_FOUND);
+        assert(tyPlatSettingsIterNext(instance, &iter, nullptr, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+        tyPlatSettingsIterEnd(instance, &iter);
+
+        assert(tyPlatSettingsIterBegin(instance, &iter, 2) == TY_ERROR_NONE);
+        assert(tyPlatSettingsIterNext(instance, &iter, nullptr, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+        tyPlatSettingsIterEnd(instance, &iter);
+
+        assert(tyPlatSettingsIterBegin(instance, &iter, -1) == TY_ERROR_NONE);
+        length = sizeof(value);
+        while (tyPlatSettingsIterNext(instance, &iter, &key, value, &length) == TY_ERROR_NONE)
+        {
+            assert(key == 0 || key == 1 || key == 0x8001);
+            assert(0 == memcmp(value, data, length));
+            counts[key == 0x8001 ? 2 : key]++;
+            length = sizeof(value);
+        }
+        tyPlatSettingsIterEnd(instance, &iter);
+        assert(counts[0] == 3 && counts[1] == 1 && counts[2] == 1);
+
+        struct Walk
+        {
+            size_t mCounts[3];
+            size_t mLimit; ///< The number of values after which the walk is stopped.
+        } walk;
+
+        auto count = [](tinyInstance *, uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength, void *aContext) {
+            Walk *walk = static_cast<Walk *>(aContext);
+
+            for (uint16_t i = 0; i < aValueLength; i++)
+            {
+                assert(aValue[i] == i);
+            }
+            walk->mCounts[aKey == 0x8001 ? 2 : aKey]++;
+            return walk->mCounts[0] + walk->mCounts[1] + walk->mCounts[2] < walk->mLimit;
+        };
+
+        walk = {{0, 0, 0}, SIZE_MAX};
+        assert(tyPlatSettingsForEach(instance, -2, count, &walk) == TY_ERROR_INVALID_ARGS);
+        assert(tyPlatSettingsForEach(instance, -1, count, &walk) == TY_ERROR_NONE);
+        assert(walk.mCounts[0] == 3 && walk.mCounts[1] == 1 && walk.mCounts[2] == 1);
+        walk = {{0, 0, 0}, 2};
+        assert(tyPlatSettingsForEach(instance, 2, count, &walk) == TY_ERROR_NONE);
+        assert(tyPlatSettingsForEach(instance, 0, count, &walk) == TY_ERROR_NONE);
+        assert(walk.mCounts[0] == 2 && walk.mCounts[1] == 0 && walk.mCounts[2] == 0);
+    }
+    tyPlatSettingsWipe(instance);
+
     // verify delete record
     assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
     assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data) / 2) == TY_ERROR_NONE);
@@ -386,6 +1346,961 @@ int main()
         assert(tyPlatSettingsGet(instance, 0, 0, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
     }
     tyPlatSettingsWipe(instance);
+
+#if TYSETTINGS_POSIX_CONFIG_MMAP_ENABLE
+    // verify borrowing values from the settings file
+    assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 1, data, 0) == TY_ERROR_NONE);
+    {
+        const uint8_t *view;
+        uint16_t       length;
+
+        assert(tyPlatSettingsGetView(instance, 0, 0, &view, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data));
+        assert(0 == memcmp(view, data, length));
+
+        assert(tyPlatSettingsGetView(instance, 1, 0, &view, &length) == TY_ERROR_NONE);
+        assert(length == 0);
+
+        assert(tyPlatSettingsGetView(instance, 0, 1, &view, &length) == TY_ERROR_NOT_FOUND);
+        assert(tyPlatSettingsGetView(instance, 2, 0, &view, &length) == TY_ERROR_NOT_FOUND);
+    }
+    tyPlatSettingsWipe(instance);
+#endif
+
+#if TYSETTINGS_CONFIG_COMPRESS_THRESHOLD > 0
+    // verify compressed and raw values coexist and report the length of the value
+    {
+        uint8_t     large[4096];
+        uint8_t     value[sizeof(large)];
+        uint16_t    length;
+        struct stat st;
+
+        for (size_t i = 0; i < sizeof(large); i++)
+        {
+            large[i] = static_cast<uint8_t>(i % 7);
+        }
+
+        assert(tyPlatSettingsSet(instance, 0, large, sizeof(large)) == TY_ERROR_NONE);
+        assert(tyPlatSettingsAdd(instance, 0, data, 8) == TY_ERROR_NONE);
+        assert(tyPlatSettingsFlush(instance) == TY_ERROR_NONE);
+        assert(stat(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data", &st) == 0);
+        assert(st.st_size < static_cast<off_t>(sizeof(large)));
+
+        for (int reload = 0; reload < 2; reload++)
+        {
+            length = sizeof(value);
+            assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(large) && 0 == memcmp(value, large, length));
+
+            // only the requested beginning of the value is decompressed
+            length = 10;
+            memset(value, 0xff, sizeof(value));
+            assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(large) && 0 == memcmp(value, large, 10) && value[10] == 0xff);
+
+            length = 0;
+            assert(tyPlatSettingsGet(instance, 0, 0, nullptr, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(large));
+
+            length = sizeof(value);
+            assert(tyPlatSettingsGet(instance, 0, 1, value, &length) == TY_ERROR_NONE);
+            assert(length == 8 && 0 == memcmp(value, data, length));
+
+#if TYSETTINGS_POSIX_CONFIG_MMAP_ENABLE
+            {
+                const uint8_t *view;
+
+                assert(tyPlatSettingsGetView(instance, 0, 0, &view, &length) == TY_ERROR_NOT_IMPLEMENTED);
+                assert(tyPlatSettingsGetView(instance, 0, 1, &view, &length) == TY_ERROR_NONE);
+            }
+#endif
+
+            tyPlatSettingsDeinit(instance);
+            tyPlatSettingsInit(instance, nullptr, 0);
+        }
+    }
+    tyPlatSettingsWipe(instance);
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_DEDUP_ENABLE
+    // verify identical values are stored once and survive removing some of their links
+    {
+        uint8_t     large[1024];
+        uint8_t     value[sizeof(large)];
+        uint16_t    length;
+        struct stat st;
+
+        for (size_t i = 0; i < sizeof(large); i++)
+        {
+            large[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            assert(tyPlatSettingsAdd(instance, 0, large, sizeof(large)) == TY_ERROR_NONE);
+        }
+        assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+        assert(tyPlatSettingsFlush(instance) == TY_ERROR_NONE);
+        assert(stat(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data", &st) == 0);
+        assert(st.st_size < static_cast<off_t>(2 * sizeof(large)));
+
+        assert(tyPlatSettingsDelete(instance, 0, 0) == TY_ERROR_NONE);
+        assert(tyPlatSettingsDelete(instance, 0, 3) == TY_ERROR_NONE);
+
+        for (int reload = 0; reload < 2; reload++)
+        {
+            for (int i = 0; i < 14; i++)
+            {
+                length = sizeof(value);
+                assert(tyPlatSettingsGet(instance, 0, i, value, &length) == TY_ERROR_NONE);
+                assert(length == sizeof(large) && 0 == memcmp(value, large, length));
+            }
+
+            length = sizeof(value);
+            assert(tyPlatSettingsGet(instance, 0, 14, value, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(data) && 0 == memcmp(value, data, length));
+
+            tyPlatSettingsDeinit(instance);
+            tyPlatSettingsInit(instance, nullptr, 0);
+        }
+
+        // replacing the last links to a value by a link to the same value keeps it
+        assert(tyPlatSettingsSet(instance, 0, large, sizeof(large)) == TY_ERROR_NONE);
+        large[0] ^= 1;
+        assert(tyPlatSettingsAdd(instance, 0, large, sizeof(large)) == TY_ERROR_NONE);
+
+        for (int reload = 0; reload < 2; reload++)
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                length = sizeof(value);
+                assert(tyPlatSettingsGet(instance, 0, i, value, &length) == TY_ERROR_NONE);
+                assert(length == sizeof(large) && (value[0] ^ large[0]) == (i == 0 ? 1 : 0));
+                assert(0 == memcmp(value + 1, large + 1, length - 1));
+            }
+            assert(tyPlatSettingsGet(instance, 0, 2, value, &length) == TY_ERROR_NOT_FOUND);
+
+            tyPlatSettingsDeinit(instance);
+            tyPlatSettingsInit(instance, nullptr, 0);
+        }
+    }
+    tyPlatSettingsWipe(instance);
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+    // verify records are loaded from the index and their values are checked when read
+    {
+        uint8_t     value[sizeof(data)];
+        uint16_t    length;
+        struct stat st;
+
+        assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+        assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data) / 2) == TY_ERROR_NONE);
+        tyPlatSettingsDeinit(instance);
+        assert(stat(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.index", &st) == 0);
+
+#if !TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+        {
+            // flips the first byte of the first value, after the file header and the entry header
+            const off_t kFirstValue = 8 + 16;
+            uint8_t     first;
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+            int fd = open(getLatestBank(), O_RDWR);
+#else
+            int fd = open(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data", O_RDWR);
+#endif
+
+            assert(fd >= 0);
+            assert(pread(fd, &first, sizeof(first), kFirstValue) == sizeof(first));
+            first ^= 0xff;
+            assert(pwrite(fd, &first, sizeof(first), kFirstValue) == sizeof(first));
+            assert(close(fd) == 0);
+        }
+
+        // the corrupted value is not read, reading it fails like an input/output error
+        tyPlatSettingsInit(instance, nullptr, 0);
+        length = 0;
+        assert(tyPlatSettingsGet(instance, 0, 0, nullptr, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data));
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 0, 1, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 2 && 0 == memcmp(value, data, length));
+        tyPlatSettingsDeinit(instance);
+
+        assert(unlink(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.index") == 0);
+        tyPlatSettingsInit(instance, nullptr, 0);
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        // without the index the corrupted bank is read as a whole and the other bank is loaded instead
+        length = 0;
+        assert(tyPlatSettingsGet(instance, 0, 0, nullptr, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data));
+        assert(tyPlatSettingsGet(instance, 0, 1, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+#else
+        // without the index the settings file is read as a whole and truncated before the corrupted entry
+        assert(tyPlatSettingsGet(instance, 0, 0, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+#endif
+#else
+        // entries appended to the log after the index was written are read from the settings file
+        tyPlatSettingsInit(instance, nullptr, 0);
+        assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data) / 3) == TY_ERROR_NONE);
+        tyPlatSettingsDeinit(instance);
+        tyPlatSettingsInit(instance, nullptr, 0);
+
+        for (int i = 0; i < 3; i++)
+        {
+            length = sizeof(value);
+            assert(tyPlatSettingsGet(instance, 0, i, value, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(data) / (i + 1) && 0 == memcmp(value, data, length));
+        }
+#endif
+    }
+    tyPlatSettingsWipe(instance);
+#endif
+
+#if !TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    // verify a torn or corrupted tail only drops the invalid entries, the tail key is kept in the same shard as key 0
+    const uint16_t kTailKey = TYSETTINGS_POSIX_CONFIG_SHARDS > 1 ? 3 * (TYSETTINGS_POSIX_CONFIG_SHARDS - 1) : 1;
+
+    assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 0, data, sizeof(data) / 2) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, kTailKey, data, sizeof(data) / 3) == TY_ERROR_NONE);
+    tyPlatSettingsDeinit(instance);
+    for (int corrupt = 0; corrupt < 2; corrupt++)
+    {
+        // a complete entry with a wrong checksum and an incomplete entry
+        const uint8_t torn[] = {0x02, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xef, 0xbe,
+                                0xad, 0xde, 0x01, 0x02, 0x03, 0x04, 0x00, 0x00, sizeof(data), 0x00, 0x00};
+        uint8_t       value[sizeof(data)];
+        uint16_t      length = sizeof(value);
+        int           fd     = open(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data", O_RDWR | O_APPEND);
+
+        assert(fd >= 0);
+        if (corrupt)
+        {
+            // flips the last byte of the value of the tail key
+            off_t   end = lseek(fd, 0, SEEK_END);
+            uint8_t last;
+
+            assert(pread(fd, &last, sizeof(last), end - 1) == sizeof(last));
+            last ^= 0xff;
+            assert(ftruncate(fd, end - 1) == 0);
+            assert(write(fd, &last, sizeof(last)) == sizeof(last));
+        }
+        assert(write(fd, torn, sizeof(torn)) == sizeof(torn));
+        assert(close(fd) == 0);
+
+        tyPlatSettingsInit(instance, nullptr, 0);
+
+        assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data));
+        assert(0 == memcmp(value, data, length));
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 0, 1, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 2);
+        assert(0 == memcmp(value, data, length));
+        assert(tyPlatSettingsGet(instance, kTailKey, 0, nullptr, nullptr) ==
+               (corrupt ? TY_ERROR_NOT_FOUND : TY_ERROR_NONE));
+        assert(tyPlatSettingsGet(instance, 2, 0, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+
+        tyPlatSettingsDeinit(instance);
+    }
+    tyPlatSettingsInit(instance, nullptr, 0);
+    tyPlatSettingsWipe(instance);
+#else
+    // verify rewrites commit the banks in place, a broken bank rolls back to the other one
+    {
+        struct stat before[2];
+        struct stat after;
+        uint8_t     value[sizeof(data)];
+        uint16_t    length;
+
+        for (int bank = 0; bank < 2; bank++)
+        {
+            assert(stat(kBanks[bank], &before[bank]) == 0);
+        }
+
+        // Each value is committed on its own, also in write-back mode.
+        assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+        tyPlatSettingsFlush(instance);
+        assert(tyPlatSettingsSet(instance, 0, data, sizeof(data) / 2) == TY_ERROR_NONE);
+        tyPlatSettingsFlush(instance);
+
+        for (int bank = 0; bank < 2; bank++)
+        {
+            assert(stat(kBanks[bank], &after) == 0 && after.st_ino == before[bank].st_ino);
+        }
+
+        // A corrupted trailer of the latest bank rolls back to the value before.
+        tyPlatSettingsDeinit(instance);
+        {
+            off_t       end;
+            const char *path = getLatestBank(nullptr, &end);
+            int         fd   = open(path, O_RDWR);
+            off_t       crc;
+            uint8_t     byte;
+
+            // flips a byte of the checksum
+            assert(fd >= 0);
+            crc = end - kBankTrailerSize + static_cast<off_t>(offsetof(BankTrailer, mCrc));
+            assert(pread(fd, &byte, sizeof(byte), crc) == sizeof(byte));
+            byte ^= 0xff;
+            assert(pwrite(fd, &byte, sizeof(byte), crc) == sizeof(byte));
+            assert(close(fd) == 0);
+        }
+        tyPlatSettingsInit(instance, nullptr, 0);
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) && 0 == memcmp(value, data, length));
+
+        // The broken bank is overwritten by the next rewrite.
+        assert(tyPlatSettingsSet(instance, 0, data, sizeof(data) / 3) == TY_ERROR_NONE);
+        tyPlatSettingsDeinit(instance);
+        tyPlatSettingsInit(instance, nullptr, 0);
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 3);
+
+        // A settings file of the single-bank layout is taken over.
+        tyPlatSettingsDeinit(instance);
+        {
+            off_t       end;
+            const char *path = getLatestBank(nullptr, &end);
+
+            assert(path == kBanks[0] || rename(path, kBanks[0]) == 0);
+            assert(truncate(kBanks[0], end - kBankTrailerSize) == 0);
+            unlink(kBanks[1]);
+        }
+        tyPlatSettingsInit(instance, nullptr, 0);
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 3);
+        assert(stat(kBanks[1], &after) == 0 && after.st_size > 0);
+    }
+    tyPlatSettingsWipe(instance);
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    // verify changes are only written on flush
+    {
+        struct stat before;
+        struct stat after;
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        uint64_t generation[2];
+#endif
+
+        assert(tyPlatSettingsFlush(instance) == TY_ERROR_NONE);
+        assert(stat(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data", &before) == 0);
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        getLatestBank(&generation[0]);
+#endif
+        assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGet(instance, 0, 0, nullptr, nullptr) == TY_ERROR_NONE);
+        assert(stat(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data", &after) == 0);
+        assert(after.st_ino == before.st_ino && after.st_size == before.st_size);
+
+        assert(tyPlatSettingsFlush(instance) == TY_ERROR_NONE);
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        getLatestBank(&generation[1]);
+        assert(generation[1] == generation[0] + 1);
+#else
+        assert(stat(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data", &after) == 0);
+        assert(after.st_ino != before.st_ino && after.st_size > before.st_size);
+#endif
+    }
+    tyPlatSettingsWipe(instance);
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL > 0
+    // verify changes are written once the interval expires without further changes
+    {
+        const uint8_t        kValue[] = {'w', 'r', 'i', 't', 't', 'e', 'n', ' ', 'b', 'a', 'c', 'k'};
+        std::vector<uint8_t> image;
+        struct stat          st;
+        int                  fd;
+
+        assert(tyPlatSettingsFlush(instance) == TY_ERROR_NONE);
+        assert(tyPlatSettingsSet(instance, 0, kValue, sizeof(kValue)) == TY_ERROR_NONE);
+        usleep((TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL + 500) * 1000);
+
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        fd = open(getLatestBank(), O_RDONLY);
+#else
+        fd = open(TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data", O_RDONLY);
+#endif
+        assert(fd >= 0 && fstat(fd, &st) == 0);
+        image.resize(static_cast<size_t>(st.st_size));
+        assert(read(fd, image.data(), image.size()) == st.st_size && close(fd) == 0);
+        assert(std::search(image.begin(), image.end(), kValue, kValue + sizeof(kValue)) != image.end());
+    }
+    tyPlatSettingsWipe(instance);
+#endif
+#endif
+
+    // verify batches
+    assert(tyPlatSettingsCommitBatch(instance) == TY_ERROR_INVALID_STATE);
+    assert(tyPlatSettingsAbortBatch(instance) == TY_ERROR_INVALID_STATE);
+    assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 1, data, sizeof(data)) == TY_ERROR_NONE);
+    for (int commit = 0; commit < 2; commit++)
+    {
+        uint8_t  value[sizeof(data)];
+        uint16_t length = sizeof(value);
+
+        assert(tyPlatSettingsBeginBatch(instance) == TY_ERROR_NONE);
+        assert(tyPlatSettingsBeginBatch(instance) == TY_ERROR_INVALID_STATE);
+        assert(tyPlatSettingsSet(instance, 0, data + 1, sizeof(data) / 2) == TY_ERROR_NONE);
+        assert(tyPlatSettingsAdd(instance, 1, data + 2, sizeof(data) / 3) == TY_ERROR_NONE);
+        assert(tyPlatSettingsDelete(instance, 1, 0) == TY_ERROR_NONE);
+
+        // staged values are visible inside the batch
+        assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 2);
+        assert(0 == memcmp(value, data + 1, length));
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 1, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 3);
+        assert(0 == memcmp(value, data + 2, length));
+        assert(tyPlatSettingsGet(instance, 1, 1, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+
+        if (commit)
+        {
+            assert(tyPlatSettingsCommitBatch(instance) == TY_ERROR_NONE);
+            tyPlatSettingsDeinit(instance);
+            tyPlatSettingsInit(instance, nullptr, 0);
+
+            length = sizeof(value);
+            assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(data) / 2);
+            assert(0 == memcmp(value, data + 1, length));
+            length = sizeof(value);
+            assert(tyPlatSettingsGet(instance, 1, 0, value, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(data) / 3);
+            assert(0 == memcmp(value, data + 2, length));
+        }
+        else
+        {
+            assert(tyPlatSettingsAbortBatch(instance) == TY_ERROR_NONE);
+
+            length = sizeof(value);
+            assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(data));
+            assert(0 == memcmp(value, data, length));
+            length = sizeof(value);
+            assert(tyPlatSettingsGet(instance, 1, 0, value, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(data));
+            assert(0 == memcmp(value, data, length));
+        }
+        assert(tyPlatSettingsGet(instance, 1, 1, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+    }
+    tyPlatSettingsWipe(instance);
+
+    // verify records behind a deleted one are still found, also after reloading the settings file
+    assert(tyPlatSettingsAdd(instance, 2, data, sizeof(data) / 2) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 1, data, sizeof(data)) == TY_ERROR_NONE);
+    assert(tyPlatSettingsAdd(instance, 2, data + 1, sizeof(data) / 3) == TY_ERROR_NONE);
+    assert(tyPlatSettingsSet(instance, 3, data + 2, sizeof(data) / 4) == TY_ERROR_NONE);
+    assert(tyPlatSettingsDelete(instance, 1, 0) == TY_ERROR_NONE);
+    for (int reload = 0; reload < 2; reload++)
+    {
+        uint8_t  value[sizeof(data)];
+        uint16_t length = sizeof(value);
+
+        assert(tyPlatSettingsGet(instance, 2, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 2);
+        assert(0 == memcmp(value, data, length));
+
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 2, 1, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 3);
+        assert(0 == memcmp(value, data + 1, length));
+
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 3, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) / 4);
+        assert(0 == memcmp(value, data + 2, length));
+
+        assert(tyPlatSettingsGet(instance, 1, 0, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+
+        tyPlatSettingsDeinit(instance);
+        tyPlatSettingsInit(instance, nullptr, 0);
+    }
+    tyPlatSettingsWipe(instance);
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    // verify changes staged while the log is not appended to stay staged until the next rewrite, a copy of the settings
+    // file taken at any time replays the removals of key 0 in order and never holds the second value alone
+    {
+        const uint8_t           kFirst  = 1;
+        const uint8_t           kSecond = 2;
+        ty::Posix::SettingsFile file;
+        uint64_t                change;
+
+        auto checkReplay = [] {
+            ty::Posix::SettingsFile copy;
+            std::vector<uint8_t>    image;
+            struct stat             st;
+            uint8_t                 value;
+            uint16_t                length = sizeof(value);
+            int                     fd     = open(TY_CONFIG_POSIX_SETTINGS_PATH "/replay.data", O_RDONLY);
+            ssize_t                 size;
+
+            assert(fd >= 0 && fstat(fd, &st) == 0);
+            image.resize(static_cast<size_t>(st.st_size));
+            size = read(fd, image.data(), image.size());
+            assert(size == st.st_size && close(fd) == 0);
+            fd = open(TY_CONFIG_POSIX_SETTINGS_PATH "/replay_copy.data", O_WRONLY | O_CREAT | O_TRUNC, 0600);
+            assert(fd >= 0 && write(fd, image.data(), static_cast<size_t>(size)) == size && close(fd) == 0);
+
+            assert(copy.Init("replay_copy", false) == TY_ERROR_NONE);
+            assert(copy.Get(0, 0, &value, &length) == TY_ERROR_NOT_FOUND || value == kFirst);
+            copy.Deinit();
+        };
+
+        assert(file.Init("replay", false) == TY_ERROR_NONE);
+
+        // the batch is staged while an earlier change rewrites the settings file, it is written by its own commit
+        file.Add(0, &kFirst, sizeof(kFirst));
+        file.Add(0, &kSecond, sizeof(kSecond));
+        assert(file.SetAsync(1, &kFirst, sizeof(kFirst), change) == TY_ERROR_NONE);
+        assert(file.BeginBatch() == TY_ERROR_NONE);
+        assert(file.Delete(0, 1) == TY_ERROR_NONE);
+        file.Persist(change);
+        assert(file.CommitBatch() == TY_ERROR_NONE);
+        assert(file.Delete(0, 0) == TY_ERROR_NONE);
+        checkReplay();
+
+        // the second value is removed while a batch of the writer is synced, the first one once the writer is done
+        for (uint8_t iteration = 0; iteration < 20; iteration++)
+        {
+            std::atomic<bool> done{false};
+
+            file.Add(0, &kFirst, sizeof(kFirst));
+            file.Add(0, &kSecond, sizeof(kSecond));
+
+            std::thread writer([&file, &done, iteration] {
+                assert(file.BeginBatch() == TY_ERROR_NONE);
+                file.Set(1, &iteration, sizeof(iteration));
+                assert(file.CommitBatch() == TY_ERROR_NONE);
+                done = true;
+            });
+
+            while (!done && access(TY_CONFIG_POSIX_SETTINGS_PATH "/replay.Swap", F_OK) != 0)
+            {
+            }
+            while (file.DeleteAsync(0, 1, change) == TY_ERROR_INVALID_STATE)
+            {
+            }
+            writer.join();
+            assert(file.DeleteAsync(0, 0, change) == TY_ERROR_NONE);
+            checkReplay();
+            file.Persist(change);
+        }
+
+        file.Deinit();
+        assert(unlink(TY_CONFIG_POSIX_SETTINGS_PATH "/replay.data") == 0);
+        assert(unlink(TY_CONFIG_POSIX_SETTINGS_PATH "/replay_copy.data") == 0);
+#if TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+        assert(unlink(TY_CONFIG_POSIX_SETTINGS_PATH "/replay.index") == 0);
+#endif
+    }
+#endif
+
+    // verify concurrent writers and readers, each writer owns one key and readers always see a complete value
+    {
+        const int                kThreads    = 4;
+        const int                kIterations = 50;
+        std::vector<std::thread> threads;
+
+        for (int i = 0; i < kThreads; i++)
+        {
+            threads.emplace_back([instance, i]() {
+                for (int j = 0; j < kIterations; j++)
+                {
+                    uint8_t value[sizeof(data)];
+
+                    memset(value, j, sizeof(value));
+                    assert(tyPlatSettingsSet(instance, static_cast<uint16_t>(i), value, sizeof(value)) ==
+                           TY_ERROR_NONE);
+                    assert(tyPlatSettingsAdd(instance, static_cast<uint16_t>(kThreads + i), value, 1) ==
+                           TY_ERROR_NONE);
+                }
+            });
+            threads.emplace_back([instance, i]() {
+                for (int j = 0; j < kIterations; j++)
+                {
+                    uint8_t  value[sizeof(data)];
+                    uint16_t length = sizeof(value);
+
+                    if (tyPlatSettingsGet(instance, static_cast<uint16_t>(i), 0, value, &length) == TY_ERROR_NONE)
+                    {
+                        assert(length == sizeof(value));
+                        for (uint16_t k = 1; k < length; k++)
+                        {
+                            assert(value[k] == value[0]);
+                        }
+                    }
+                }
+            });
+        }
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        for (int reload = 0; reload < 2; reload++)
+        {
+            for (int i = 0; i < kThreads; i++)
+            {
+                uint8_t  value[sizeof(data)];
+                uint16_t length = sizeof(value);
+
+                assert(tyPlatSettingsGet(instance, static_cast<uint16_t>(i), 0, value, &length) == TY_ERROR_NONE);
+                assert(length == sizeof(value) && value[0] == kIterations - 1);
+                assert(tyPlatSettingsGet(instance, static_cast<uint16_t>(kThreads + i), kIterations - 1, value,
+                                         &length) == TY_ERROR_NONE);
+                assert(tyPlatSettingsGet(instance, static_cast<uint16_t>(kThreads + i), kIterations, nullptr,
+                                         nullptr) == TY_ERROR_NOT_FOUND);
+            }
+
+            tyPlatSettingsDeinit(instance);
+            tyPlatSettingsInit(instance, nullptr, 0);
+        }
+    }
+    tyPlatSettingsWipe(instance);
+
+    // verify a settings file larger than 64 KiB is rewritten completely
+    {
+        const uint16_t kRecords = 100;
+        uint8_t        value[1000];
+        uint16_t       length;
+
+        for (uint16_t i = 0; i < kRecords; i++)
+        {
+            memset(value, i, sizeof(value));
+            assert(tyPlatSettingsAdd(instance, 1, value, sizeof(value)) == TY_ERROR_NONE);
+        }
+        assert(tyPlatSettingsSet(instance, 0, data, sizeof(data)) == TY_ERROR_NONE);
+        assert(tyPlatSettingsDelete(instance, 1, 0) == TY_ERROR_NONE);
+        assert(tyPlatSettingsAdd(instance, 2, data, sizeof(data)) == TY_ERROR_NONE);
+
+        for (int reload = 0; reload < 2; reload++)
+        {
+            for (uint16_t i = 1; i < kRecords; i++)
+            {
+                length = sizeof(value);
+                assert(tyPlatSettingsGet(instance, 1, i - 1, value, &length) == TY_ERROR_NONE);
+                assert(length == sizeof(value) && value[0] == i && value[sizeof(value) - 1] == i);
+            }
+            assert(tyPlatSettingsGet(instance, 1, kRecords - 1, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+
+            length = sizeof(value);
+            assert(tyPlatSettingsGet(instance, 2, 0, value, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(data) && 0 == memcmp(value, data, length));
+
+            tyPlatSettingsDeinit(instance);
+            tyPlatSettingsInit(instance, nullptr, 0);
+        }
+    }
+    tyPlatSettingsWipe(instance);
+
+    // verify instances with their own base names keep separate stores and run in parallel
+    {
+        const int                kInstances  = 2;
+        const int                kIterations = 50;
+        uint8_t                  instances[kInstances];
+        std::vector<std::thread> threads;
+        uint16_t                 length;
+
+        auto otherInstance = [&instances](int aIndex) { return reinterpret_cast<tinyInstance *>(&instances[aIndex]); };
+        auto initOther     = [&otherInstance](int aIndex) {
+            char baseName[16];
+
+            snprintf(baseName, sizeof(baseName), "self_test_%d", aIndex);
+            assert(tyPlatSettingsSetBaseName(otherInstance(aIndex), baseName) == TY_ERROR_NONE);
+            tyPlatSettingsInit(otherInstance(aIndex), nullptr, 0);
+        };
+
+        assert(tyPlatSettingsSetBaseName(instance, "other") == TY_ERROR_INVALID_STATE);
+        assert(tyPlatSettingsSetBaseName(otherInstance(0), "") == TY_ERROR_INVALID_ARGS);
+        assert(tyPlatSettingsSetBaseName(otherInstance(0), "self_test/0") == TY_ERROR_INVALID_ARGS);
+
+        for (int i = 0; i < kInstances; i++)
+        {
+            uint8_t value = static_cast<uint8_t>(0xa0 + i);
+
+            initOther(i);
+            tyPlatSettingsWipe(otherInstance(i));
+            assert(tyPlatSettingsSet(otherInstance(i), 1, &value, sizeof(value)) == TY_ERROR_NONE);
+
+            threads.emplace_back([&otherInstance, i]() {
+                for (int j = 0; j < kIterations; j++)
+                {
+                    uint8_t value = static_cast<uint8_t>(j);
+
+                    assert(tyPlatSettingsAdd(otherInstance(i), 0, &value, sizeof(value)) == TY_ERROR_NONE);
+                }
+            });
+        }
+        assert(tyPlatSettingsSet(instance, 1, data, sizeof(data)) == TY_ERROR_NONE);
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        for (int reload = 0; reload < 2; reload++)
+        {
+            for (int i = 0; i < kInstances; i++)
+            {
+                uint8_t value;
+
+                length = sizeof(value);
+                assert(tyPlatSettingsGet(otherInstance(i), 1, 0, &value, &length) == TY_ERROR_NONE);
+                assert(length == sizeof(value) && value == 0xa0 + i);
+                assert(tyPlatSettingsGet(otherInstance(i), 0, kIterations - 1, nullptr, nullptr) == TY_ERROR_NONE);
+                assert(tyPlatSettingsGet(otherInstance(i), 0, kIterations, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+                tyPlatSettingsDeinit(otherInstance(i));
+            }
+
+            length = 0;
+            assert(tyPlatSettingsGet(instance, 0, 0, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+            assert(tyPlatSettingsGet(instance, 1, 0, nullptr, &length) == TY_ERROR_NONE);
+            assert(length == sizeof(data));
+
+            for (int i = 0; i < kInstances; i++)
+            {
+                initOther(i);
+            }
+        }
+
+        for (int i = 0; i < kInstances; i++)
+        {
+            tyPlatSettingsWipe(otherInstance(i));
+            tyPlatSettingsDeinit(otherInstance(i));
+        }
+    }
+    tyPlatSettingsWipe(instance);
+
+    // verify asynchronous changes are visible at once and their callbacks are called on the calling thread
+    {
+        const int       kChanges  = 20;
+        int             completed = 0;
+        struct pollfd   event     = {tyPlatSettingsGetEventFd(instance), POLLIN, 0};
+        uint8_t         value[sizeof(data)];
+        uint16_t        length;
+        std::thread::id self = std::this_thread::get_id();
+
+        auto callback = [](tinyInstance *aInstance, tinyError aError, void *aContext) {
+            assert(aInstance == nullptr && aError == TY_ERROR_NONE);
+            ++*static_cast<int *>(aContext);
+        };
+
+        assert(event.fd >= 0);
+        assert(tyPlatSettingsSetAsync(instance, 0, data, sizeof(data), callback, &completed) == TY_ERROR_NONE);
+        for (int i = 1; i < kChanges; i++)
+        {
+            assert(tyPlatSettingsAddAsync(instance, 1, data, static_cast<uint16_t>(i), callback, &completed) ==
+                   TY_ERROR_NONE);
+        }
+        assert(tyPlatSettingsDeleteAsync(instance, 1, 0, nullptr, nullptr) == TY_ERROR_NONE);
+        assert(tyPlatSettingsDeleteAsync(instance, 2, 0, callback, &completed) == TY_ERROR_NOT_FOUND);
+
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 0, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) && 0 == memcmp(value, data, length));
+
+        while (completed < kChanges)
+        {
+            assert(poll(&event, 1, 5000) == 1);
+            tyPlatSettingsProcess(instance);
+            assert(std::this_thread::get_id() == self);
+        }
+        assert(completed == kChanges);
+
+        assert(tyPlatSettingsBeginBatch(instance) == TY_ERROR_NONE);
+        assert(tyPlatSettingsSetAsync(instance, 0, data, 1, callback, &completed) == TY_ERROR_INVALID_STATE);
+        assert(tyPlatSettingsAbortBatch(instance) == TY_ERROR_NONE);
+
+        // pending changes are completed by deinit
+        assert(tyPlatSettingsSetAsync(instance, 3, data, sizeof(data), callback, &completed) == TY_ERROR_NONE);
+        tyPlatSettingsDeinit(instance);
+        assert(completed == kChanges + 1);
+
+        tyPlatSettingsInit(instance, nullptr, 0);
+        assert(tyPlatSettingsGet(instance, 1, kChanges - 3, nullptr, nullptr) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGet(instance, 1, kChanges - 2, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+        length = sizeof(value);
+        assert(tyPlatSettingsGet(instance, 1, 0, value, &length) == TY_ERROR_NONE && length == 2);
+        assert(tyPlatSettingsGet(instance, 3, 0, nullptr, nullptr) == TY_ERROR_NONE);
+    }
+    tyPlatSettingsWipe(instance);
+
+#if TYSETTINGS_POSIX_CONFIG_SHARDS > 1
+    // verify a change leaves the files of other shards untouched and values in the wrong shard are moved
+    {
+        char        vendorPath[sizeof(TY_CONFIG_POSIX_SETTINGS_PATH) + 32];
+        struct stat before;
+        struct stat after;
+        uint16_t    length;
+
+        snprintf(vendorPath, sizeof(vendorPath), "%s/0_1234567890abcdef.%d.data", TY_CONFIG_POSIX_SETTINGS_PATH,
+                 TYSETTINGS_POSIX_CONFIG_SHARDS - 1);
+
+        assert(tyPlatSettingsSet(instance, TY_SETTINGS_KEY_VENDOR_RESERVED_MIN, data, sizeof(data)) == TY_ERROR_NONE);
+        tyPlatSettingsFlush(instance);
+        assert(stat(vendorPath, &before) == 0);
+
+        for (uint8_t i = 0; i < 10; i++)
+        {
+            assert(tyPlatSettingsSet(instance, 0, &i, sizeof(i)) == TY_ERROR_NONE);
+        }
+        tyPlatSettingsFlush(instance);
+
+        assert(stat(vendorPath, &after) == 0);
+        assert(before.st_ino == after.st_ino && before.st_size == after.st_size);
+
+        // Moves the vendor shard into the first shard, like a store written without sharding.
+        assert(tyPlatSettingsDelete(instance, 0, -1) == TY_ERROR_NONE);
+        tyPlatSettingsDeinit(instance);
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        {
+            char  vendorSwapPath[sizeof(vendorPath)];
+            off_t end;
+
+            // Takes the latest bank without its trailer, the banks of the vendor shard are created anew.
+            snprintf(vendorSwapPath, sizeof(vendorSwapPath), "%s/0_1234567890abcdef.%d.Swap",
+                     TY_CONFIG_POSIX_SETTINGS_PATH, TYSETTINGS_POSIX_CONFIG_SHARDS - 1);
+            assert(rename(vendorPath, kBanks[0]) == 0);
+            assert(rename(vendorSwapPath, kBanks[1]) == 0);
+            assert(rename(getLatestBank(nullptr, &end), kBanks[0]) == 0);
+            assert(truncate(kBanks[0], end - kBankTrailerSize) == 0);
+            unlink(kBanks[1]);
+        }
+#else
+        assert(rename(vendorPath, TY_CONFIG_POSIX_SETTINGS_PATH "/0_1234567890abcdef.data") == 0);
+#endif
+
+        for (int reload = 0; reload < 2; reload++)
+        {
+            tyPlatSettingsInit(instance, nullptr, 0);
+            length = 0;
+            assert(tyPlatSettingsGet(instance, TY_SETTINGS_KEY_VENDOR_RESERVED_MIN, 0, nullptr, &length) ==
+                   TY_ERROR_NONE);
+            assert(length == sizeof(data));
+            assert(tyPlatSettingsGet(instance, TY_SETTINGS_KEY_VENDOR_RESERVED_MIN, 1, nullptr, nullptr) ==
+                   TY_ERROR_NOT_FOUND);
+            assert(stat(vendorPath, &after) == 0 && after.st_size > 0);
+            tyPlatSettingsDeinit(instance);
+        }
+        tyPlatSettingsInit(instance, nullptr, 0);
+    }
+    tyPlatSettingsWipe(instance);
+
+    // verify a snapshot holds either all or none of the changes of a batch committed to several shards
+    {
+        std::atomic<bool> done{false};
+        std::thread       writer([instance, &done] {
+            for (uint8_t i = 0; !done; i++)
+            {
+                assert(tyPlatSettingsBeginBatch(instance) == TY_ERROR_NONE);
+                assert(tyPlatSettingsSet(instance, 0, &i, sizeof(i)) == TY_ERROR_NONE);
+                assert(tyPlatSettingsSet(instance, TY_SETTINGS_KEY_VENDOR_RESERVED_MIN, &i, sizeof(i)) ==
+                       TY_ERROR_NONE);
+                assert(tyPlatSettingsCommitBatch(instance) == TY_ERROR_NONE);
+            }
+        });
+
+        for (int snapshot = 0; snapshot < 50; snapshot++)
+        {
+            FILE                   *image = tmpfile();
+            ty::Posix::SettingsFile file;
+            uint8_t                 values[2];
+            uint16_t                length;
+
+            assert(image != nullptr);
+            assert(tyPlatSettingsSnapshot(instance, fileno(image)) == TY_ERROR_NONE);
+            assert(file.LoadImage(fileno(image)) == TY_ERROR_NONE);
+
+            length = sizeof(values[0]);
+            if (file.Get(0, 0, &values[0], &length) == TY_ERROR_NONE)
+            {
+                length = sizeof(values[1]);
+                assert(file.Get(TY_SETTINGS_KEY_VENDOR_RESERVED_MIN, 0, &values[1], &length) == TY_ERROR_NONE);
+                assert(values[0] == values[1]);
+            }
+            else
+            {
+                assert(file.Get(TY_SETTINGS_KEY_VENDOR_RESERVED_MIN, 0, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+            }
+            assert(fclose(image) == 0);
+        }
+
+        done = true;
+        writer.join();
+    }
+    tyPlatSettingsWipe(instance);
+#endif
+
+#if TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
+    // verify sensitive keys are kept in the secure store
+    {
+        static const uint16_t kSensitiveKeys[] = {2};
+        char                  securePath[sizeof(TY_CONFIG_POSIX_SETTINGS_PATH) + 32];
+        struct stat           st;
+        tyPlatSettingsIter    iter;
+        FILE                 *image = tmpfile();
+        uint8_t               value[sizeof(data)];
+        uint16_t              length = sizeof(value);
+        uint16_t              key;
+
+        snprintf(securePath, sizeof(securePath), "%s/0_1234567890abcdef.s.data", TY_CONFIG_POSIX_SETTINGS_PATH);
+
+        // A key which becomes sensitive is moved into the secure store.
+        assert(tyPlatSettingsSet(instance, 1, data, sizeof(data) / 2) == TY_ERROR_NONE);
+        assert(tyPlatSettingsSet(instance, 2, data, sizeof(data)) == TY_ERROR_NONE);
+        tyPlatSettingsDeinit(instance);
+        tyPlatSettingsInit(instance, kSensitiveKeys, sizeof(kSensitiveKeys) / sizeof(kSensitiveKeys[0]));
+        assert(stat(securePath, &st) == 0 && (st.st_mode & 0777) == 0600 && st.st_size > 0);
+        assert(tyPlatSettingsGet(instance, 2, 0, value, &length) == TY_ERROR_NONE);
+        assert(length == sizeof(data) && 0 == memcmp(value, data, length));
+
+        // iterating all keys skips the secure store, iterating the key does not
+        assert(tyPlatSettingsIterBegin(instance, &iter, -1) == TY_ERROR_NONE);
+        length = sizeof(value);
+        assert(tyPlatSettingsIterNext(instance, &iter, &key, value, &length) == TY_ERROR_NONE && key == 1);
+        assert(tyPlatSettingsIterNext(instance, &iter, &key, value, &length) == TY_ERROR_NOT_FOUND);
+        tyPlatSettingsIterEnd(instance, &iter);
+        assert(tyPlatSettingsIterBegin(instance, &iter, 2) == TY_ERROR_NONE);
+        length = sizeof(value);
+        assert(tyPlatSettingsIterNext(instance, &iter, &key, value, &length) == TY_ERROR_NONE && key == 2);
+        assert(length == sizeof(data));
+        assert(tyPlatSettingsIterNext(instance, &iter, &key, value, &length) == TY_ERROR_NOT_FOUND);
+        tyPlatSettingsIterEnd(instance, &iter);
+
+        // snapshots leave sensitive keys out, restores keep them
+        assert(image != nullptr);
+        assert(tyPlatSettingsSnapshot(instance, fileno(image)) == TY_ERROR_NONE);
+        assert(tyPlatSettingsDelete(instance, 1, -1) == TY_ERROR_NONE);
+        assert(tyPlatSettingsRestore(instance, fileno(image)) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGet(instance, 1, 0, nullptr, nullptr) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGet(instance, 2, 0, nullptr, nullptr) == TY_ERROR_NONE);
+        assert(tyPlatSettingsGet(instance, 2, 1, nullptr, nullptr) == TY_ERROR_NOT_FOUND);
+        fclose(image);
+
+        // sensitive keys are persisted and the secure store is made private again
+        assert(chmod(securePath, 0644) == 0);
+        tyPlatSettingsDeinit(instance);
+        tyPlatSettingsInit(instance, kSensitiveKeys, sizeof(kSensitiveKeys) / sizeof(kSensitiveKeys[0]));
+        assert(stat(securePath, &st) == 0 && (st.st_mode & 0777) == 0600);
+        assert(tyPlatSettingsGet(instance, 2, 0, nullptr, nullptr) == TY_ERROR_NONE);
+
+        tyPlatSettingsWipe(instance);
+        tyPlatSettingsDeinit(instance);
+        tyPlatSettingsInit(instance, nullptr, 0);
+    }
+#endif
+
     tyPlatSettingsDeinit(instance);
 
     return 0;
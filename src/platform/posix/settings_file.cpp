@@ -6,30 +6,85 @@
  *   This file implements the settings file module for getting, setting and deleting the key-value pairs.
  */
 
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include <ty/common/code_utils.hpp>
 #include <ty/common/debug.hpp>
 #include <ty/exit_code.h>
 
+#include "crc32c.hpp"
+#include "hash64.hpp"
 #include "settings_file.hpp"
+#include "tysettings-compress.h"
+#include "tysettings-trace.h"
+
+#if TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+#define SETTINGS_FILE_COUNT(aCounter, aValue) (aCounter).fetch_add((aValue), std::memory_order_relaxed)
+#else
+#define SETTINGS_FILE_COUNT(aCounter, aValue)
+#endif
 
 namespace ty {
 namespace Posix {
 
-tinyError SettingsFile::Init(const char *aSettingsFileBaseName)
+SettingsFile::StoredValue::StoredValue(const uint8_t *aValue, uint16_t aLength)
+    : mData(aValue)
+    , mLength(aLength)
+    , mFlags(0)
+    , mHash(0)
+{
+#if TYSETTINGS_CONFIG_COMPRESS_THRESHOLD > 0
+    if (aLength >= TYSETTINGS_CONFIG_COMPRESS_THRESHOLD)
+    {
+        size_t length;
+
+        // Compressed outside of the lock, a value which does not shrink is stored as is.
+        mCompressed.resize(aLength);
+        length = tySettingsCompress(aValue, aLength, mCompressed.data(), mCompressed.size());
+
+        if (length != 0)
+        {
+            mData   = mCompressed.data();
+            mLength = static_cast<uint16_t>(length);
+            mFlags  = kFlagCompressed;
+        }
+    }
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_DEDUP_ENABLE
+    if (mLength >= TYSETTINGS_POSIX_CONFIG_DEDUP_MIN_LENGTH)
+    {
+        // The flags are part of the hash, a compressed and a raw value with the same bytes are different values.
+        mHash = Hash64(mData, mLength, mFlags);
+        mFlags |= kFlagShared;
+    }
+#endif
+}
+
+tinyError SettingsFile::Init(const char *aSettingsFileBaseName, bool aSecure)
 {
-    tinyError   error     = TY_ERROR_NONE;
     const char *directory = TY_CONFIG_POSIX_SETTINGS_PATH;
 
     TY_ASSERT((aSettingsFileBaseName != nullptr) && (strlen(aSettingsFileBaseName) < kMaxFileBaseNameSize));
     strncpy(mSettingFileBaseName, aSettingsFileBaseName, sizeof(mSettingFileBaseName) - 1);
+    mSecure = aSecure;
 
     {
         struct stat st;
@@ -45,40 +100,103 @@ tinyError SettingsFile::Init(const char *aSettingsFileBaseName)
 
         GetSettingsFilePath(fileName, false);
         mSettingsFd = open(fileName, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        VerifyOrDie(mSettingsFd != -1, TY_EXIT_ERROR_ERRNO);
+
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        // Bank B, `Load()` decides which bank is active.
+        GetSettingsFilePath(fileName, true);
+        mBankFd = open(fileName, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        VerifyOrDie(mBankFd != -1, TY_EXIT_ERROR_ERRNO);
+#endif
     }
 
-    VerifyOrDie(mSettingsFd != -1, TY_EXIT_ERROR_ERRNO);
+    // The mode only applies to new files, a file created before may be accessible by others.
+    if (mSecure)
+    {
+        VerifyOrDie(fchmod(mSettingsFd, 0600) == 0, TY_EXIT_ERROR_ERRNO);
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        VerifyOrDie(fchmod(mBankFd, 0600) == 0, TY_EXIT_ERROR_ERRNO);
+#endif
+    }
 
-    for (off_t size = lseek(mSettingsFd, 0, SEEK_END), offset = lseek(mSettingsFd, 0, SEEK_SET); offset < size;)
+    mRecords.clear();
+    mBlobs.clear();
+    mNextRecordId = 0;
+    Load();
+
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+    mBytesRead      = 0;
+    mBytesWritten   = 0;
+    mCommits        = 0;
+    mBytesRewritten = 0;
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    // Load the whole store into memory, the file is only written from now on.
+    for (auto &entry : mRecords)
     {
-        uint16_t key;
-        uint16_t length;
-        ssize_t  rval;
+        for (Record &record : entry.second)
+        {
+            record.mValue.resize(record.mLength);
+            VerifyOrDie(pread(mSettingsFd, record.mValue.data(), record.mLength, record.mOffset) == record.mLength,
+                        TY_EXIT_ERROR_ERRNO);
+            record.mOffset = kNotInFile;
+        }
+    }
 
-        rval = read(mSettingsFd, &key, sizeof(key));
-        VerifyOrExit(rval == sizeof(key), error = TY_ERROR_PARSE);
+    ApplyBlobOffsets(mBlobs, BlobOffsetMap());
 
-        rval = read(mSettingsFd, &length, sizeof(length));
-        VerifyOrExit(rval == sizeof(length), error = TY_ERROR_PARSE);
+    mDirty      = false;
+    mDirtyBytes = 0;
+#endif
 
-        offset += sizeof(key) + sizeof(length) + length;
-        VerifyOrExit(offset == lseek(mSettingsFd, length, SEEK_CUR), error = TY_ERROR_PARSE);
+    if (mFormat != kFormatCurrent)
+    {
+        // Convert a new settings file or one in the legacy format.
+        Rewrite();
     }
-
-exit:
-    if (error == TY_ERROR_PARSE)
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    else if (mGeneration == 0)
+    {
+        // Commit a settings file of the single-bank layout to a bank.
+        Rewrite();
+    }
+#endif
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    else if (IsLogCompactionDue())
     {
-        VerifyOrDie(ftruncate(mSettingsFd, 0) == 0, TY_EXIT_ERROR_ERRNO);
+        Rewrite();
     }
+#endif
 
-    return error;
+    Map();
+
+    return TY_ERROR_NONE;
 }
 
 void SettingsFile::Deinit(void)
 {
     VerifyOrExit(mSettingsFd != -1);
+
+    // Changes of a batch which was never committed are lost.
+    if (mBatchActive)
+    {
+        mBatchActive = false;
+        mRecords     = std::move(mBatchBackup);
+        mBlobs       = std::move(mBatchBlobs);
+        mBatchBackup.clear();
+        mBatchBlobs.clear();
+    }
+
+    Commit(mChangeSeq);
+
+    Unmap();
     VerifyOrDie(close(mSettingsFd) == 0, TY_EXIT_ERROR_ERRNO);
     mSettingsFd = -1;
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    VerifyOrDie(close(mBankFd) == 0, TY_EXIT_ERROR_ERRNO);
+    mBankFd = -1;
+#endif
 
 exit:
     return;
@@ -86,264 +204,2116 @@ exit:
 
 tinyError SettingsFile::Get(uint16_t aKey, int aIndex, uint8_t *aValue, uint16_t *aValueLength)
 {
-    tinyError error = TY_ERROR_NOT_FOUND;
-    off_t     size;
-    off_t     offset;
+    std::shared_lock<std::shared_mutex> lock(mLock);
 
-    TY_ASSERT(mSettingsFd >= 0);
+    return ReadValue(aKey, aIndex, aValue, aValueLength);
+}
 
-    size   = lseek(mSettingsFd, 0, SEEK_END);
-    offset = lseek(mSettingsFd, 0, SEEK_SET);
-    VerifyOrExit(offset == 0 && size >= 0, error = TY_ERROR_PARSE);
+tinyError SettingsFile::GetMany(const tyPlatSettingsRequest *const *aRequests, size_t aCount)
+{
+    std::shared_lock<std::shared_mutex> lock(mLock);
+    tinyError                           error = TY_ERROR_NONE;
 
-    while (offset < size)
+    for (size_t i = 0; i < aCount; i++)
     {
-        uint16_t key;
-        uint16_t length;
-        ssize_t  rval;
-
-        rval = read(mSettingsFd, &key, sizeof(key));
-        VerifyOrExit(rval == sizeof(key), error = TY_ERROR_PARSE);
+        const tyPlatSettingsRequest &request = *aRequests[i];
+        tinyError                    requestError =
+            ReadValue(request.mKey, request.mIndex, request.mValue, request.mValueLength);
 
-        rval = read(mSettingsFd, &length, sizeof(length));
-        VerifyOrExit(rval == sizeof(length), error = TY_ERROR_PARSE);
+        if (request.mError != nullptr)
+        {
+            *request.mError = requestError;
+        }
 
-        if (key == aKey)
+        // A read error takes precedence over settings which are not found.
+        if (error == TY_ERROR_NONE || requestError == TY_ERROR_PARSE)
         {
-            if (aIndex == 0)
-            {
-                error = TY_ERROR_NONE;
+            error = requestError;
+        }
+    }
 
-                if (aValueLength)
-                {
-                    if (aValue)
-                    {
-                        uint16_t readLength = (length <= *aValueLength ? length : *aValueLength);
+    return error;
+}
 
-                        VerifyOrExit(read(mSettingsFd, aValue, readLength) == readLength, error = TY_ERROR_PARSE);
-                    }
+tinyError SettingsFile::ReadValue(uint16_t aKey, int aIndex, uint8_t *aValue, uint16_t *aValueLength)
+{
+    tinyError     error = TY_ERROR_NONE;
+    const Record *record;
 
-                    *aValueLength = length;
-                }
+    TY_ASSERT(mSettingsFd >= 0);
+
+    record = FindRecord(aKey, aIndex);
+    VerifyOrExit(record != nullptr, error = TY_ERROR_NOT_FOUND);
+
+    if (aValueLength)
+    {
+        if (aValue)
+        {
+            SuccessOrExit(error = VerifyRecord(*record));
+        }
+
+        if (aValue && record->IsCompressed())
+        {
+            SuccessOrExit(error = ReadCompressed(*record, aValue,
+                                                 record->mValueLength <= *aValueLength ? record->mValueLength
+                                                                                       : *aValueLength));
+        }
+        else if (aValue)
+        {
+            uint16_t readLength = (record->mLength <= *aValueLength ? record->mLength : *aValueLength);
 
-                break;
+            SETTINGS_FILE_COUNT(mBytesRead, readLength);
+
+            if (record->IsStaged())
+            {
+                memcpy(aValue, record->mValue.data(), readLength);
+            }
+            else if (mMap != nullptr)
+            {
+                memcpy(aValue, mMap + record->mOffset, readLength);
             }
             else
             {
-                --aIndex;
+                VerifyOrExit(pread(mSettingsFd, aValue, readLength, record->mOffset) == readLength,
+                             error = TY_ERROR_PARSE);
             }
         }
 
-        offset += sizeof(key) + sizeof(length) + length;
-        VerifyOrExit(offset == lseek(mSettingsFd, length, SEEK_CUR), error = TY_ERROR_PARSE);
+        *aValueLength = record->mValueLength;
     }
 
 exit:
     return error;
 }
 
-void SettingsFile::Set(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
+tinyError SettingsFile::ReadCompressed(const Record &aRecord, uint8_t *aValue, uint16_t aLength)
 {
-    int swapFd = -1;
+    tinyError            error = TY_ERROR_NONE;
+    std::vector<uint8_t> buffer;
+    const uint8_t       *compressed;
 
-    TY_ASSERT(mSettingsFd >= 0);
+    SETTINGS_FILE_COUNT(mBytesRead, aRecord.mLength);
 
-    switch (Delete(aKey, -1, &swapFd))
+    compressed = GetStoredValue(aRecord, buffer);
+    VerifyOrExit(compressed != nullptr, error = TY_ERROR_PARSE);
+    VerifyOrExit(tySettingsDecompress(compressed, aRecord.mLength, aValue, aLength), error = TY_ERROR_PARSE);
+
+exit:
+    return error;
+}
+
+tinyError SettingsFile::VerifyRecord(const Record &aRecord)
+{
+    tinyError            error = TY_ERROR_NONE;
+    EntryHeader          header;
+    std::vector<uint8_t> buffer;
+    const uint8_t       *value;
+    off_t                offset = aRecord.mOffset - (aRecord.IsShared() ? kHashSize : 0);
+
+    VerifyOrExit(!aRecord.IsStaged() && !aRecord.mVerified.Get());
+
+    // A shared record is verified by the entry of its blob, whose checksum covers the hash as well.
+    VerifyOrExit(pread(mSettingsFd, &header, sizeof(header), offset - kEntryHeaderSize) == sizeof(header),
+                 error = TY_ERROR_PARSE);
+    VerifyOrExit(header.mLength == aRecord.mLength + (aRecord.IsShared() ? kHashSize : 0), error = TY_ERROR_PARSE);
+    value = GetStoredValue(aRecord, buffer);
+    VerifyOrExit(value != nullptr, error = TY_ERROR_PARSE);
+    SETTINGS_FILE_COUNT(mBytesRead, kEntryHeaderSize + aRecord.mLength);
+
+    if (aRecord.IsShared())
+    {
+        VerifyOrExit(header.mCrc == GetEntryCrc(header, aRecord.mHash, value), error = TY_ERROR_PARSE);
+    }
+    else
     {
-    case TY_ERROR_NONE:
-    case TY_ERROR_NOT_FOUND:
-        break;
+        VerifyOrExit(header.mCrc == GetEntryCrc(header, value), error = TY_ERROR_PARSE);
+    }
+
+    aRecord.mVerified.Set();
+
+exit:
+    return error;
+}
+
+const uint8_t *SettingsFile::GetStoredValue(const Record &aRecord, std::vector<uint8_t> &aBuffer)
+{
+    const uint8_t *value = nullptr;
 
-    default:
-        TY_ASSERT(false);
-        break;
+    if (aRecord.IsStaged())
+    {
+        value = aRecord.mValue.data();
+    }
+    else if (mMap != nullptr)
+    {
+        value = mMap + aRecord.mOffset;
+    }
+    else
+    {
+        aBuffer.resize(aRecord.mLength);
+        VerifyOrExit(pread(mSettingsFd, aBuffer.data(), aRecord.mLength, aRecord.mOffset) == aRecord.mLength);
+        value = aBuffer.data();
     }
 
-    VerifyOrDie(write(swapFd, &aKey, sizeof(aKey)) == sizeof(aKey) &&
-                    write(swapFd, &aValueLength, sizeof(aValueLength)) == sizeof(aValueLength) &&
-                    write(swapFd, aValue, aValueLength) == aValueLength,
-                TY_EXIT_FAILURE);
+exit:
+    return value;
+}
+
+tinyError SettingsFile::GetView(uint16_t aKey, int aIndex, const uint8_t **aData, uint16_t *aLength)
+{
+    std::shared_lock<std::shared_mutex> lock(mLock);
+    tinyError                           error = TY_ERROR_NONE;
+    const Record *record;
+
+    TY_ASSERT(mSettingsFd >= 0);
+    TY_ASSERT(aData != nullptr && aLength != nullptr);
+
+    record = FindRecord(aKey, aIndex);
+    VerifyOrExit(record != nullptr, error = TY_ERROR_NOT_FOUND);
+
+    // A compressed value has no contiguous copy to point to.
+    VerifyOrExit(!record->IsCompressed(), error = TY_ERROR_NOT_IMPLEMENTED);
+    SuccessOrExit(error = VerifyRecord(*record));
+
+    if (record->IsStaged())
+    {
+        *aData = record->mValue.data();
+    }
+    // An empty value has no storage in the (possibly empty and therefore unmapped) file.
+    else if (record->mLength == 0)
+    {
+        *aData = mMap;
+    }
+    else
+    {
+        VerifyOrExit(mMap != nullptr, error = TY_ERROR_NOT_IMPLEMENTED);
+        *aData = mMap + record->mOffset;
+    }
+
+    *aLength = record->mLength;
 
-    SwapPersist(swapFd);
+exit:
+    return error;
 }
 
-void SettingsFile::Add(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
+tinyError SettingsFile::GetNextKey(uint16_t aKey, uint16_t &aNextKey)
 {
-    off_t size;
-    int   swapFd;
+    std::shared_lock<std::shared_mutex> lock(mLock);
+    tinyError                           error = TY_ERROR_NONE;
+    auto                                entry = mRecords.lower_bound(aKey);
 
     TY_ASSERT(mSettingsFd >= 0);
 
-    size   = lseek(mSettingsFd, 0, SEEK_END);
-    swapFd = SwapOpen();
+    VerifyOrExit(entry != mRecords.end(), error = TY_ERROR_NOT_FOUND);
+    aNextKey = entry->first;
+
+exit:
+    return error;
+}
+
+tinyError SettingsFile::GetNext(uint16_t &aKey, int &aIndex, bool aNextKeys, uint8_t *aValue, uint16_t *aValueLength)
+{
+    std::shared_lock<std::shared_mutex> lock(mLock);
+    tinyError                           error = TY_ERROR_NONE;
+    auto                                entry = mRecords.lower_bound(aKey);
+
+    TY_ASSERT(mSettingsFd >= 0 && aIndex >= 0);
 
-    if (size > 0)
+    if (entry != mRecords.end() && entry->first == aKey && static_cast<size_t>(aIndex) >= entry->second.size())
     {
-        VerifyOrDie(0 == lseek(mSettingsFd, 0, SEEK_SET), TY_EXIT_ERROR_ERRNO);
-        SwapWrite(swapFd, static_cast<uint16_t>(size));
+        ++entry;
     }
 
-    VerifyOrDie(write(swapFd, &aKey, sizeof(aKey)) == sizeof(aKey) &&
-                    write(swapFd, &aValueLength, sizeof(aValueLength)) == sizeof(aValueLength) &&
-                    write(swapFd, aValue, aValueLength) == aValueLength,
-                TY_EXIT_FAILURE);
+    VerifyOrExit(entry != mRecords.end(), error = TY_ERROR_NOT_FOUND);
+
+    if (entry->first != aKey)
+    {
+        VerifyOrExit(aNextKeys, error = TY_ERROR_NOT_FOUND);
+        aKey   = entry->first;
+        aIndex = 0;
+    }
+
+    error = ReadValue(aKey, aIndex, aValue, aValueLength);
+
+exit:
+    return error;
+}
+
+void SettingsFile::Set(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
+{
+    StoredValue value(aValue, aValueLength);
+    uint64_t    change;
+
+    {
+        std::lock_guard<std::shared_mutex> lock(mLock);
+
+        ApplySet(aKey, value);
+        change = Change(value.GetLength());
+    }
 
-    SwapPersist(swapFd);
+    Commit(change);
+}
+
+uint32_t SettingsFile::Add(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
+{
+    StoredValue value(aValue, aValueLength);
+    uint64_t    change;
+    uint32_t    id;
+
+    {
+        std::lock_guard<std::shared_mutex> lock(mLock);
+
+        ApplyAdd(aKey, value);
+        id     = mRecords[aKey].back().mId;
+        change = Change(value.GetLength());
+    }
+
+    Commit(change);
+
+    return id;
 }
 
 tinyError SettingsFile::Delete(uint16_t aKey, int aIndex)
 {
-    return Delete(aKey, aIndex, nullptr);
+    tinyError error  = TY_ERROR_NONE;
+    uint64_t  change = 0;
+
+    {
+        std::lock_guard<std::shared_mutex> lock(mLock);
+
+        SuccessOrExit(error = ApplyDelete(aKey, aIndex));
+        change = Change(0);
+    }
+
+exit:
+    Commit(change);
+    return error;
 }
 
-tinyError SettingsFile::Delete(uint16_t aKey, int aIndex, int *aSwapFd)
+tinyError SettingsFile::GetById(uint16_t aKey, uint32_t aId, uint8_t *aValue, uint16_t *aValueLength)
 {
-    tinyError error = TY_ERROR_NOT_FOUND;
-    off_t     size;
-    off_t     offset;
-    int       swapFd;
+    std::shared_lock<std::shared_mutex> lock(mLock);
+    int                                 index = FindIndex(aKey, aId);
 
     TY_ASSERT(mSettingsFd >= 0);
 
-    size   = lseek(mSettingsFd, 0, SEEK_END);
-    offset = lseek(mSettingsFd, 0, SEEK_SET);
-    swapFd = SwapOpen();
+    return (index == -1) ? TY_ERROR_NOT_FOUND : ReadValue(aKey, index, aValue, aValueLength);
+}
 
-    TY_ASSERT(swapFd != -1);
-    TY_ASSERT(offset == 0);
-    VerifyOrExit(offset == 0 && size >= 0, error = TY_ERROR_FAILED);
+tinyError SettingsFile::DeleteById(uint16_t aKey, uint32_t aId)
+{
+    tinyError error  = TY_ERROR_NONE;
+    uint64_t  change = 0;
 
-    while (offset < size)
     {
-        uint16_t key;
-        uint16_t length;
-        ssize_t  rval;
+        std::lock_guard<std::shared_mutex> lock(mLock);
+        int                                index = FindIndex(aKey, aId);
 
-        rval = read(mSettingsFd, &key, sizeof(key));
-        VerifyOrExit(rval == sizeof(key), error = TY_ERROR_FAILED);
+        VerifyOrExit(index != -1, error = TY_ERROR_NOT_FOUND);
+        SuccessOrExit(error = ApplyDelete(aKey, index));
+        change = Change(0);
+    }
 
-        rval = read(mSettingsFd, &length, sizeof(length));
-        VerifyOrExit(rval == sizeof(length), error = TY_ERROR_FAILED);
+exit:
+    Commit(change);
+    return error;
+}
 
-        offset += sizeof(key) + sizeof(length) + length;
+tinyError SettingsFile::SetAsync(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength, uint64_t &aChange)
+{
+    StoredValue                        value(aValue, aValueLength);
+    std::lock_guard<std::shared_mutex> lock(mLock);
+    tinyError                          error = TY_ERROR_NONE;
 
-        if (aKey == key)
-        {
-            if (aIndex == 0)
-            {
-                VerifyOrExit(offset == lseek(mSettingsFd, length, SEEK_CUR), error = TY_ERROR_FAILED);
-                SwapWrite(swapFd, static_cast<uint16_t>(size - offset));
-                error = TY_ERROR_NONE;
-                break;
-            }
-            else if (aIndex == -1)
-            {
-                VerifyOrExit(offset == lseek(mSettingsFd, length, SEEK_CUR), error = TY_ERROR_FAILED);
-                error = TY_ERROR_NONE;
-                continue;
-            }
-            else
-            {
-                --aIndex;
-            }
-        }
+    VerifyOrExit(!mBatchActive, error = TY_ERROR_INVALID_STATE);
+
+    ApplySet(aKey, value);
+    Change(value.GetLength());
+    aChange = mChangeSeq;
+
+exit:
+    return error;
+}
 
-        rval = write(swapFd, &key, sizeof(key));
-        VerifyOrExit(rval == sizeof(key), error = TY_ERROR_FAILED);
+tinyError SettingsFile::AddAsync(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength, uint64_t &aChange)
+{
+    StoredValue                        value(aValue, aValueLength);
+    std::lock_guard<std::shared_mutex> lock(mLock);
+    tinyError                          error = TY_ERROR_NONE;
 
-        rval = write(swapFd, &length, sizeof(length));
-        VerifyOrExit(rval == sizeof(length), error = TY_ERROR_FAILED);
+    VerifyOrExit(!mBatchActive, error = TY_ERROR_INVALID_STATE);
 
-        SwapWrite(swapFd, length);
-    }
+    ApplyAdd(aKey, value);
+    Change(value.GetLength());
+    aChange = mChangeSeq;
+
+exit:
+    return error;
+}
+
+tinyError SettingsFile::DeleteAsync(uint16_t aKey, int aIndex, uint64_t &aChange)
+{
+    std::lock_guard<std::shared_mutex> lock(mLock);
+    tinyError                          error = TY_ERROR_NONE;
+
+    VerifyOrExit(!mBatchActive, error = TY_ERROR_INVALID_STATE);
+
+    SuccessOrExit(error = ApplyDelete(aKey, aIndex));
+    Change(0);
+    aChange = mChangeSeq;
 
 exit:
-    if (aSwapFd != nullptr)
+    return error;
+}
+
+void SettingsFile::Persist(uint64_t aChange)
+{
+    Commit(aChange);
+}
+
+void SettingsFile::ApplySet(uint16_t aKey, const StoredValue &aValue)
+{
+    RecordList removed;
+    uint16_t   flags;
+
+    TY_ASSERT(mSettingsFd >= 0);
+
+    RemoveRecords(aKey, -1, removed);
+    flags = ResolveFlags(aValue);
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    if (CanLogAppend())
     {
-        *aSwapFd = swapFd;
+        LogAppend(aKey, kOpSet, aValue.GetData(), aValue.GetLength(), flags, aValue.GetHash(), removed);
     }
-    else if (error == TY_ERROR_NONE)
+    else
     {
-        SwapPersist(swapFd);
+        StageRecord(aKey, aValue, flags);
+        mRewriteNeeded = true;
+    }
+#else
+    StageRecord(aKey, aValue, flags);
+#endif
+}
+
+void SettingsFile::ApplyAdd(uint16_t aKey, const StoredValue &aValue)
+{
+    uint16_t flags;
+
+    TY_ASSERT(mSettingsFd >= 0);
+
+    flags = ResolveFlags(aValue);
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    if (CanLogAppend())
+    {
+        LogAppend(aKey, kOpAdd, aValue.GetData(), aValue.GetLength(), flags, aValue.GetHash(), RecordList());
+    }
+    else
+    {
+        StageRecord(aKey, aValue, flags);
+        mRewriteNeeded = true;
     }
-    else if (error == TY_ERROR_NOT_FOUND)
+#else
+    StageRecord(aKey, aValue, flags);
+#endif
+}
+
+tinyError SettingsFile::ApplyDelete(uint16_t aKey, int aIndex)
+{
+    tinyError  error = TY_ERROR_NONE;
+    RecordList removed;
+
+    TY_ASSERT(mSettingsFd >= 0);
+
+    RemoveRecords(aKey, aIndex, removed);
+    VerifyOrExit(!removed.empty(), error = TY_ERROR_NOT_FOUND);
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    if (CanLogAppend())
     {
-        SwapDiscard(swapFd);
+        int32_t index = aIndex;
+
+        // The tombstone carries the index, replaying the log reproduces the same removal.
+        LogAppend(aKey, kOpDelete, reinterpret_cast<const uint8_t *>(&index), sizeof(index), 0, 0, removed);
     }
-    else if (error == TY_ERROR_FAILED)
+    else
     {
-        SwapDiscard(swapFd);
-        DieNow(error);
+        mRewriteNeeded = true;
     }
+#endif
 
+exit:
     return error;
 }
 
 void SettingsFile::Wipe(void)
 {
-    VerifyOrDie(0 == ftruncate(mSettingsFd, 0), TY_EXIT_ERROR_ERRNO);
+    uint64_t change;
+
+    {
+        std::lock_guard<std::shared_mutex> lock(mLock);
+
+        mRecords.clear();
+        mBlobs.clear();
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+        mRewriteNeeded = true;
+#endif
+        change = Change(0);
+    }
+
+    Commit(change);
 }
 
-void SettingsFile::GetSettingsFilePath(char aFileName[kMaxFilePathSize], bool aSwap)
+tinyError SettingsFile::Flush(void)
 {
-    snprintf(aFileName, kMaxFilePathSize, TY_CONFIG_POSIX_SETTINGS_PATH "/%s.%s", mSettingFileBaseName,
-             (aSwap ? "Swap" : "data"));
+    tinyError error  = TY_ERROR_NONE;
+    uint64_t  change = 0;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mLock);
+
+        VerifyOrExit(!mBatchActive, error = TY_ERROR_INVALID_STATE);
+        change = mChangeSeq;
+    }
+
+exit:
+    Commit(change);
+    return error;
 }
 
-int SettingsFile::SwapOpen(void)
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+void SettingsFile::SetWriteBackHandler(WriteBackHandler aHandler, void *aContext)
 {
-    char fileName[kMaxFilePathSize];
-    int  fd;
-
-    GetSettingsFilePath(fileName, true);
+    std::lock_guard<std::shared_mutex> lock(mLock);
 
-    fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
-    VerifyOrDie(fd != -1, TY_EXIT_ERROR_ERRNO);
+    mWriteBackHandler = aHandler;
+    mWriteBackContext = aContext;
 
-    return fd;
+    if (mDirty && mWriteBackHandler != nullptr)
+    {
+        mWriteBackHandler(*this, mWriteBackContext);
+    }
 }
 
-void SettingsFile::SwapWrite(int aFd, uint16_t aLength)
+void SettingsFile::WriteBackIfDue(void)
 {
-    const size_t kBlockSize = 512;
-    uint8_t      buffer[kBlockSize];
+    uint64_t change = 0;
 
-    while (aLength > 0)
     {
-        uint16_t count = aLength >= sizeof(buffer) ? sizeof(buffer) : aLength;
-        ssize_t  rval  = read(mSettingsFd, buffer, count);
+        // Exclusively, `Rewrite()` clears `mDirty` holding the lock shared.
+        std::lock_guard<std::shared_mutex> lock(mLock);
 
-        VerifyOrDie(rval > 0, TY_EXIT_FAILURE);
-        count = static_cast<uint16_t>(rval);
-        rval  = write(aFd, buffer, count);
-        TY_ASSERT(rval == count);
-        VerifyOrDie(rval == count, TY_EXIT_FAILURE);
-        aLength -= count;
+        VerifyOrExit(!mBatchActive && IsFlushDue());
+        change = mChangeSeq;
     }
+
+exit:
+    Commit(change);
 }
+#endif
 
-void SettingsFile::SwapPersist(int aFd)
+tinyError SettingsFile::BeginBatch(void)
 {
-    char swapFile[kMaxFilePathSize];
-    char dataFile[kMaxFilePathSize];
+    std::lock_guard<std::shared_mutex> lock(mLock);
+    tinyError                          error = TY_ERROR_NONE;
 
-    GetSettingsFilePath(swapFile, true);
-    GetSettingsFilePath(dataFile, false);
+    VerifyOrExit(!mBatchActive, error = TY_ERROR_INVALID_STATE);
 
-    VerifyOrDie(0 == close(mSettingsFd), TY_EXIT_ERROR_ERRNO);
-    VerifyOrDie(0 == fsync(aFd), TY_EXIT_ERROR_ERRNO);
-    VerifyOrDie(0 == rename(swapFile, dataFile), TY_EXIT_ERROR_ERRNO);
+    mBatchBackup = mRecords;
+    mBatchBlobs  = mBlobs;
+    mBatchActive = true;
 
-    mSettingsFd = aFd;
+exit:
+    return error;
+}
+
+tinyError SettingsFile::CommitBatch(void)
+{
+    tinyError error  = TY_ERROR_NONE;
+    uint64_t  change = 0;
+
+    {
+        std::lock_guard<std::shared_mutex> lock(mLock);
+
+        VerifyOrExit(mBatchActive, error = TY_ERROR_INVALID_STATE);
+
+        mBatchActive = false;
+        mBatchBackup.clear();
+        mBatchBlobs.clear();
+        change = Change(0);
+    }
+
+exit:
+    Commit(change);
+    return error;
 }
 
-void SettingsFile::SwapDiscard(int aFd)
+tinyError SettingsFile::AbortBatch(void)
 {
-    char swapFileName[kMaxFilePathSize];
+    std::lock_guard<std::shared_mutex> lock(mLock);
+    tinyError                          error = TY_ERROR_NONE;
+
+    VerifyOrExit(mBatchActive, error = TY_ERROR_INVALID_STATE);
 
-    VerifyOrDie(0 == close(aFd), TY_EXIT_ERROR_ERRNO);
-    GetSettingsFilePath(swapFileName, true);
-    VerifyOrDie(0 == unlink(swapFileName), TY_EXIT_ERROR_ERRNO);
+    mBatchActive = false;
+    mRecords     = std::move(mBatchBackup);
+    mBlobs       = std::move(mBatchBlobs);
+    mBatchBackup.clear();
+    mBatchBlobs.clear();
+
+exit:
+    return error;
+}
+
+void SettingsFile::PinImages(SettingsFile *aFiles, unsigned aCount, ImagePin *aPins)
+{
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+
+    for (unsigned i = 0; i < aCount; i++)
+    {
+        uint64_t change;
+
+        {
+            std::shared_lock<std::shared_mutex> lock(aFiles[i].mLock);
+
+            change = aFiles[i].mChangeSeq;
+        }
+
+        aFiles[i].Commit(change);
+    }
+
+    // Holding all locks at once, no settings file is replaced or appended to while the others are pinned.
+    for (unsigned i = 0; i < aCount; i++)
+    {
+        locks.emplace_back(aFiles[i].mLock);
+    }
+
+    for (unsigned i = 0; i < aCount; i++)
+    {
+        SettingsFile &file = aFiles[i];
+        ImagePin     &pin  = aPins[i];
+
+        TY_ASSERT(file.mSettingsFd >= 0);
+
+        // Settings files are only replaced by a rename or appended to, never changed in place. The duplicate keeps the
+        // current file open once a rewrite replaces it.
+        pin.mFd = dup(file.mSettingsFd);
+        VerifyOrDie(pin.mFd != -1, TY_EXIT_ERROR_ERRNO);
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+        pin.mSize = file.mLogSize;
+#else
+        {
+            struct stat st;
+
+            VerifyOrDie(fstat(pin.mFd, &st) == 0, TY_EXIT_ERROR_ERRNO);
+            pin.mSize = st.st_size;
+        }
+#endif
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        // The active bank is overwritten in place by the rewrite after next, which waits for the copy.
+        pin.mSize -= kBankTrailerSize;
+        pin.mGeneration = file.mGeneration;
+        file.PinBank(pin.mGeneration);
+#endif
+    }
+}
+
+tinyError SettingsFile::CopyImage(const ImagePin &aPin, int aFd, bool aWithHeader)
+{
+    tinyError error  = TY_ERROR_NONE;
+    off_t     offset = aWithHeader ? 0 : static_cast<off_t>(sizeof(FileHeader));
+
+    TY_SETTINGS_TRACE(snapshot_copy__start, aPin.mSize);
+    error = CopyRange(aPin.mFd, offset, aPin.mSize - offset, aFd);
+    TY_SETTINGS_TRACE(snapshot_copy__done, aPin.mSize);
+    SETTINGS_FILE_COUNT(mBytesRead, static_cast<uint64_t>(aPin.mSize - offset));
+
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    UnpinBank(aPin.mGeneration);
+#endif
+    VerifyOrDie(close(aPin.mFd) == 0, TY_EXIT_ERROR_ERRNO);
+
+    return error;
+}
+
+tinyError SettingsFile::LoadImage(int aFd)
+{
+    tinyError            error = TY_ERROR_NONE;
+    std::vector<uint8_t> buffer;
+    struct stat          st;
+
+    VerifyOrExit(fstat(aFd, &st) == 0 && S_ISREG(st.st_mode), error = TY_ERROR_PARSE);
+    buffer.resize(static_cast<size_t>(st.st_size));
+    VerifyOrExit(pread(aFd, buffer.data(), buffer.size(), 0) == st.st_size, error = TY_ERROR_PARSE);
+
+    mRecords.clear();
+    mBlobs.clear();
+
+    // Unlike a settings file, an image is not truncated to its valid entries but rejected.
+    VerifyOrExit(LoadEntries(buffer.data(), 0, st.st_size) == st.st_size && mFormat == kFormatCurrent,
+                 error = TY_ERROR_PARSE);
+
+    for (auto &entry : mRecords)
+    {
+        for (Record &record : entry.second)
+        {
+            record.mValue.assign(&buffer[static_cast<size_t>(record.mOffset)],
+                                 &buffer[static_cast<size_t>(record.mOffset)] + record.mLength);
+            record.mOffset = kNotInFile;
+        }
+    }
+
+    ApplyBlobOffsets(mBlobs, BlobOffsetMap());
+
+    mSettingsFd = aFd;
+
+exit:
+    if (error != TY_ERROR_NONE)
+    {
+        mRecords.clear();
+        mBlobs.clear();
+    }
+
+    return error;
+}
+
+SettingsFile::Record *SettingsFile::FindRecord(uint16_t aKey, int aIndex)
+{
+    Record *record = nullptr;
+    auto    entry  = mRecords.find(aKey);
+
+    VerifyOrExit(entry != mRecords.end());
+    VerifyOrExit(aIndex >= 0 && static_cast<size_t>(aIndex) < entry->second.size());
+    record = &entry->second[static_cast<size_t>(aIndex)];
+
+exit:
+    return record;
+}
+
+int SettingsFile::FindIndex(uint16_t aKey, uint32_t aId) const
+{
+    int  index = -1;
+    auto entry = mRecords.find(aKey);
+
+    VerifyOrExit(entry != mRecords.end());
+
+    {
+        // Records are appended with increasing identifiers, the records of a key are sorted by identifier.
+        const RecordList &records  = entry->second;
+        auto              isBefore = [](const Record &aRecord, uint32_t aValue) { return aRecord.mId < aValue; };
+        auto              record   = std::lower_bound(records.begin(), records.end(), aId, isBefore);
+
+        VerifyOrExit(record != records.end() && record->mId == aId);
+        index = static_cast<int>(record - records.begin());
+    }
+
+exit:
+    return index;
+}
+
+void SettingsFile::InsertRecord(const EntryHeader &aHeader, const uint8_t *aValue, off_t aOffset)
+{
+    RecordList &records = mRecords[aHeader.mKey];
+    uint32_t    id      = (aHeader.mId == kNoRecordId) ? mNextRecordId : aHeader.mId;
+
+    // Entries of the legacy format carry no identifier, new records continue behind the largest identifier loaded.
+    mNextRecordId = std::max(mNextRecordId, id + 1);
+
+    if (aHeader.mFlags & kFlagShared)
+    {
+        uint64_t    hash;
+        const Blob *blob;
+
+        // The record is located at the value of its blob, which is in the file already.
+        memcpy(&hash, aValue, sizeof(hash));
+        blob = &mBlobs.at(hash);
+        TY_ASSERT(blob->mOffset != kNotInFile);
+
+        records.push_back({id, aHeader.mKey, blob->mLength,
+                           static_cast<uint16_t>(blob->mFlags | kFlagShared), blob->mValueLength, blob->mOffset, {},
+                           hash, true});
+        RetainBlob(records.back());
+    }
+    else
+    {
+        uint16_t valueLength =
+            (aHeader.mFlags & kFlagCompressed) ? tySettingsGetDecompressedLength(aValue) : aHeader.mLength;
+
+        records.push_back(
+            {id, aHeader.mKey, aHeader.mLength, aHeader.mFlags, valueLength, aOffset, {}, 0, true});
+    }
+}
+
+void SettingsFile::RemoveRecords(uint16_t aKey, int aIndex, RecordList &aRemoved)
+{
+    auto entry = mRecords.find(aKey);
+
+    VerifyOrExit(entry != mRecords.end());
+
+    if (aIndex == -1)
+    {
+        for (const Record &record : entry->second)
+        {
+            ReleaseBlob(record);
+        }
+
+        aRemoved.insert(aRemoved.end(), entry->second.begin(), entry->second.end());
+        entry->second.clear();
+    }
+    else if (aIndex >= 0 && static_cast<size_t>(aIndex) < entry->second.size())
+    {
+        ReleaseBlob(entry->second[static_cast<size_t>(aIndex)]);
+        aRemoved.push_back(entry->second[static_cast<size_t>(aIndex)]);
+        entry->second.erase(entry->second.begin() + aIndex);
+    }
+
+    if (entry->second.empty())
+    {
+        mRecords.erase(entry);
+    }
+
+exit:
+    return;
+}
+
+void SettingsFile::StageRecord(uint16_t aKey, const StoredValue &aValue, uint16_t aFlags)
+{
+    const uint8_t *data   = aValue.GetData();
+    Record         record = {mNextRecordId++, aKey, aValue.GetLength(), aFlags, 0, kNotInFile,
+                             std::vector<uint8_t>(data, data + aValue.GetLength()),
+                             (aFlags & kFlagShared) ? aValue.GetHash() : 0, true};
+
+    record.mValueLength = record.IsCompressed() ? tySettingsGetDecompressedLength(data) : record.mLength;
+
+    if (record.IsShared())
+    {
+        RetainBlob(record);
+    }
+
+    mRecords[aKey].push_back(std::move(record));
+}
+
+uint16_t SettingsFile::ResolveFlags(const StoredValue &aValue)
+{
+    uint16_t             flags = aValue.GetFlags();
+    std::vector<uint8_t> buffer;
+    const Record        *shared;
+    Record               stored;
+    const uint8_t       *value;
+    auto                 blob = mBlobs.find(aValue.GetHash());
+
+    VerifyOrExit((flags & kFlagShared) && blob != mBlobs.end());
+
+    if (blob->second.mOffset != kNotInFile)
+    {
+        stored = {kNoRecordId, 0, blob->second.mLength, static_cast<uint16_t>(blob->second.mFlags | kFlagShared),
+                  blob->second.mValueLength, blob->second.mOffset, {}, blob->first, true};
+        shared = &stored;
+    }
+    else
+    {
+        shared = FindShared(blob->first, blob->second);
+    }
+
+    // The value is only shared with a blob of the same bytes, not merely of the same hash.
+    value = (shared != nullptr) ? GetStoredValue(*shared, buffer) : nullptr;
+
+    if (value == nullptr || shared->mFlags != flags || shared->mLength != aValue.GetLength() ||
+        memcmp(value, aValue.GetData(), aValue.GetLength()) != 0)
+    {
+        flags &= ~kFlagShared;
+    }
+
+exit:
+    return flags;
+}
+
+const SettingsFile::Record *SettingsFile::FindShared(uint64_t aHash, Blob &aBlob)
+{
+    const Record *shared = nullptr;
+    int           index  = (aBlob.mId == kNoRecordId) ? -1 : FindIndex(aBlob.mKey, aBlob.mId);
+
+    if (index != -1)
+    {
+        ExitNow(shared = FindRecord(aBlob.mKey, index));
+    }
+
+    // The record last known to link to the blob was removed, any other one is found by a scan.
+    for (const auto &entry : mRecords)
+    {
+        for (const Record &record : entry.second)
+        {
+            if (record.IsShared() && record.mHash == aHash)
+            {
+                aBlob.mKey = record.mKey;
+                aBlob.mId  = record.mId;
+                ExitNow(shared = &record);
+            }
+        }
+    }
+
+exit:
+    return shared;
+}
+
+void SettingsFile::RegisterBlob(uint64_t aHash, const EntryHeader &aHeader, const uint8_t *aValue, off_t aOffset)
+{
+    uint16_t length = aHeader.mLength - kHashSize;
+    Blob    &blob   = mBlobs.emplace(aHash, Blob{kNotInFile, 0, 0, 0, 0, 0, kNoRecordId}).first->second;
+
+    // A blob is dead while no record links to it, a second blob of the same value is never linked to. Records staged
+    // while the log was compacted may link to the blob before it is written.
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    if (blob.mOffset != kNotInFile || blob.mRefs == 0)
+    {
+        mLogDeadBytes += kEntryHeaderSize + aHeader.mLength;
+    }
+#endif
+    VerifyOrExit(blob.mOffset == kNotInFile);
+
+    blob.mOffset      = aOffset;
+    blob.mLength      = length;
+    blob.mFlags       = aHeader.mFlags;
+    blob.mValueLength = (aHeader.mFlags & kFlagCompressed) ? tySettingsGetDecompressedLength(aValue) : length;
+
+exit:
+    return;
+}
+
+void SettingsFile::RetainBlob(const Record &aRecord)
+{
+    Blob &blob = mBlobs
+                     .emplace(aRecord.mHash, Blob{kNotInFile, aRecord.mLength,
+                                                  static_cast<uint16_t>(aRecord.mFlags & ~kFlagShared),
+                                                  aRecord.mValueLength, 0, 0, kNoRecordId})
+                     .first->second;
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    if (blob.mRefs == 0 && blob.mOffset != kNotInFile)
+    {
+        mLogDeadBytes -= kEntryHeaderSize + kHashSize + blob.mLength;
+    }
+#endif
+
+    if (blob.mRefs++ == 0 || blob.mId == kNoRecordId)
+    {
+        blob.mKey = aRecord.mKey;
+        blob.mId  = aRecord.mId;
+    }
+}
+
+void SettingsFile::ReleaseBlob(const Record &aRecord)
+{
+    auto blob = mBlobs.find(aRecord.mHash);
+
+    VerifyOrExit(aRecord.IsShared());
+    TY_ASSERT(blob != mBlobs.end() && blob->second.mRefs > 0);
+
+    if (blob->second.mId == aRecord.mId)
+    {
+        blob->second.mId = kNoRecordId;
+    }
+
+    VerifyOrExit(--blob->second.mRefs == 0);
+
+    // A blob in the file stays known until the next rewrite, a later link to the same value reuses it.
+    if (blob->second.mOffset == kNotInFile)
+    {
+        mBlobs.erase(blob);
+    }
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    else
+    {
+        mLogDeadBytes += kEntryHeaderSize + kHashSize + blob->second.mLength;
+    }
+#endif
+
+exit:
+    return;
+}
+
+uint64_t SettingsFile::Change(size_t aChangedBytes)
+{
+    uint64_t change = 0;
+
+    // A batch is written at once by `CommitBatch()`.
+    VerifyOrExit(!mBatchActive);
+
+    change = ++mChangeSeq;
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    {
+        bool wasDirty = mDirty;
+
+        if (!mDirty)
+        {
+            mDirty      = true;
+            mDirtySince = GetNow();
+        }
+
+        mDirtyBytes += aChangedBytes;
+
+        // Sensitive keys are not kept in memory only.
+        VerifyOrExit(!mSecure && !IsFlushDue());
+
+        // The first change held back arms the deadline of the interval, later ones are written along with it.
+        if (!wasDirty && mWriteBackHandler != nullptr)
+        {
+            mWriteBackHandler(*this, mWriteBackContext);
+        }
+
+        change = 0;
+    }
+#else
+    TY_UNUSED_VARIABLE(aChangedBytes);
+#endif
+
+exit:
+    return change;
+}
+
+void SettingsFile::Commit(uint64_t aChange)
+{
+    std::unique_lock<std::mutex> commitLock(mCommitLock, std::defer_lock);
+
+    VerifyOrExit(aChange != 0);
+
+    commitLock.lock();
+
+    // Another thread may have persisted the change while this one was waiting, together with its own.
+    VerifyOrExit(mCommittedSeq < aChange);
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    {
+        int      fd;
+        uint64_t change;
+        bool     rewrite;
+
+        {
+            std::shared_lock<std::shared_mutex> lock(mLock);
+
+            fd      = mSettingsFd;
+            change  = mChangeSeq;
+            rewrite = mRewriteNeeded;
+        }
+
+        // Appended entries only need to be synced, one sync covers all entries appended so far.
+        if (!rewrite)
+        {
+            TY_SETTINGS_TRACE(log_fsync__start, change);
+            VerifyOrDie(0 == fdatasync(fd), TY_EXIT_ERROR_ERRNO);
+            TY_SETTINGS_TRACE(log_fsync__done, change);
+            SETTINGS_FILE_COUNT(mCommits, 1);
+            mCommittedSeq = change;
+            ExitNow();
+        }
+    }
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    {
+        std::unique_lock<std::mutex> pinLock(mBankPinLock);
+
+        // The banks alternate, the inactive bank to be overwritten holds the generation before the active one. Waiting
+        // before `Rewrite()` takes the lock lets writers stage their changes meanwhile.
+        mBankUnpinned.wait(pinLock, [this] { return mBankPins[(mGeneration + 1) & 1] == 0; });
+    }
+#endif
+
+    Rewrite();
+
+exit:
+    return;
+}
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+bool SettingsFile::IsFlushDue(void) const
+{
+    bool due = false;
+
+    VerifyOrExit(mDirty);
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_MAX_DIRTY_BYTES > 0
+    VerifyOrExit(mDirtyBytes < TYSETTINGS_POSIX_CONFIG_WRITE_BACK_MAX_DIRTY_BYTES, due = true);
+#endif
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL > 0
+    VerifyOrExit(GetNow() - mDirtySince < TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL, due = true);
+#endif
+
+exit:
+    return due;
+}
+
+uint64_t SettingsFile::GetNow(void)
+{
+    struct timespec now;
+
+    VerifyOrDie(0 == clock_gettime(CLOCK_MONOTONIC, &now), TY_EXIT_ERROR_ERRNO);
+
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + static_cast<uint64_t>(now.tv_nsec) / 1000000;
+}
+#endif
+
+void SettingsFile::Load(void)
+{
+    off_t size;
+    off_t validSize;
+
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    // Without a valid bank, bank A is read like the settings file of the single-bank layout.
+    VerifyOrExit(!LoadBanks());
+#endif
+
+    size = lseek(mSettingsFd, 0, SEEK_END);
+    VerifyOrDie(size >= 0, TY_EXIT_ERROR_ERRNO);
+    validSize = LoadFile(size);
+
+    // Everything behind the last valid entry is the remainder of a torn write and is dropped.
+    if (validSize < size)
+    {
+        VerifyOrDie(ftruncate(mSettingsFd, validSize) == 0, TY_EXIT_ERROR_ERRNO);
+    }
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    mLogSize = validSize;
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+exit:
+#endif
+    return;
+}
+
+off_t SettingsFile::LoadFile(off_t aSize)
+{
+    off_t                start = 0;
+    off_t                validSize;
+    void                *map = MAP_FAILED;
+    std::vector<uint8_t> buffer;
+    const uint8_t       *data;
+
+#if TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+    // Only the entries behind those in the index are read from the settings file.
+    start = LoadIndex(aSize);
+#endif
+
+    if (aSize > start)
+    {
+        map = mmap(nullptr, static_cast<size_t>(aSize), PROT_READ, MAP_PRIVATE, mSettingsFd, 0);
+    }
+
+    if (map != MAP_FAILED)
+    {
+        data = static_cast<const uint8_t *>(map) + start;
+    }
+    else
+    {
+        buffer.resize(static_cast<size_t>(aSize - start));
+        VerifyOrDie(pread(mSettingsFd, buffer.data(), buffer.size(), start) == aSize - start, TY_EXIT_ERROR_ERRNO);
+        data = buffer.data();
+    }
+
+    TY_SETTINGS_TRACE(load_scan__start, aSize - start);
+    validSize = LoadEntries(data, start, aSize);
+    TY_SETTINGS_TRACE(load_scan__done, validSize);
+
+    if (map != MAP_FAILED)
+    {
+        VerifyOrDie(0 == munmap(map, static_cast<size_t>(aSize)), TY_EXIT_ERROR_ERRNO);
+    }
+
+    return validSize;
+}
+
+off_t SettingsFile::LoadEntries(const uint8_t *aData, off_t aStart, off_t aEnd)
+{
+    off_t offset     = aStart;
+    off_t headerSize = kEntryHeaderSize;
+
+    // The entries behind those loaded from an index continue the current format.
+    if (aStart == 0)
+    {
+        headerSize = kLegacyHeaderSize;
+        mFormat    = kFormatLegacy;
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+        mLogDeadBytes = 0;
+#endif
+    }
+
+    if (aStart == 0 && aEnd >= static_cast<off_t>(sizeof(FileHeader)))
+    {
+        FileHeader fileHeader;
+
+        memcpy(&fileHeader, aData, sizeof(fileHeader));
+
+        if (fileHeader.mMagic == kFileMagic)
+        {
+            // Never drop a settings file written by a later version.
+            VerifyOrDie(fileHeader.mVersion == kFileVersion, TY_EXIT_FAILURE);
+
+            mFormat    = kFormatCurrent;
+            headerSize = kEntryHeaderSize;
+            offset = sizeof(fileHeader);
+        }
+    }
+
+    while (offset < aEnd)
+    {
+        // The header of the legacy format is a prefix of `EntryHeader`.
+        EntryHeader    header = {0, 0, kOpAdd, 0, kNoRecordId, 0};
+        const uint8_t *value;
+        off_t          next;
+        RecordList     removed;
+
+        VerifyOrExit(aEnd - offset >= headerSize);
+        memcpy(&header, aData + (offset - aStart), static_cast<size_t>(headerSize));
+        value = aData + (offset - aStart) + headerSize;
+        next  = offset + headerSize + header.mLength;
+        VerifyOrExit(next <= aEnd);
+        VerifyOrExit(headerSize != kEntryHeaderSize || header.mCrc == GetEntryCrc(header, value));
+        VerifyOrExit((header.mFlags & ~(kFlagCompressed | kFlagShared)) == 0);
+
+        if (header.mFlags & kFlagShared)
+        {
+            uint64_t hash;
+
+            // A link carries the hash of a blob written before it, with the flags of the blob.
+            VerifyOrExit(header.mOperation == kOpAdd || header.mOperation == kOpSet);
+            VerifyOrExit(header.mFlags == kFlagShared && header.mLength == kHashSize);
+            memcpy(&hash, value, sizeof(hash));
+            VerifyOrExit(mBlobs.count(hash) != 0 && mBlobs.at(hash).mOffset != kNotInFile);
+        }
+        else if (header.mOperation == kOpBlob)
+        {
+            VerifyOrExit(header.mLength >= kHashSize);
+            VerifyOrExit(!(header.mFlags & kFlagCompressed) ||
+                         header.mLength - kHashSize >= TY_SETTINGS_COMPRESS_HEADER_SIZE);
+        }
+        else
+        {
+            VerifyOrExit(!(header.mFlags & kFlagCompressed) || header.mLength >= TY_SETTINGS_COMPRESS_HEADER_SIZE);
+        }
+
+        switch (header.mOperation)
+        {
+        case kOpBlob:
+        {
+            uint64_t hash;
+
+            memcpy(&hash, value, sizeof(hash));
+            RegisterBlob(hash, header, value + kHashSize, offset + headerSize + kHashSize);
+            break;
+        }
+
+        case kOpSet:
+            RemoveRecords(header.mKey, -1, removed);
+            InsertRecord(header, value, offset + headerSize);
+            break;
+
+        case kOpAdd:
+            InsertRecord(header, value, offset + headerSize);
+            break;
+
+        case kOpDelete:
+        {
+            int32_t index;
+
+            VerifyOrExit(header.mLength == sizeof(index));
+            memcpy(&index, value, sizeof(index));
+            RemoveRecords(header.mKey, index, removed);
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+            mLogDeadBytes += next - offset;
+#endif
+            break;
+        }
+
+        default:
+            ExitNow();
+        }
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+        for (const Record &gone : removed)
+        {
+            mLogDeadBytes += headerSize + (gone.IsShared() ? kHashSize : gone.mLength);
+        }
+#endif
+
+        offset = next;
+    }
+
+exit:
+    return offset;
+}
+
+uint32_t SettingsFile::GetEntryCrc(const EntryHeader &aHeader, const uint8_t *aValue)
+{
+    return Crc32c(Crc32c(0, &aHeader, offsetof(EntryHeader, mCrc)), aValue, aHeader.mLength);
+}
+
+uint32_t SettingsFile::GetEntryCrc(const EntryHeader &aHeader, uint64_t aHash, const uint8_t *aValue)
+{
+    uint32_t crc = Crc32c(Crc32c(0, &aHeader, offsetof(EntryHeader, mCrc)), &aHash, kHashSize);
+
+    return Crc32c(crc, aValue, aHeader.mLength - kHashSize);
+}
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+void SettingsFile::LogAppend(uint16_t          aKey,
+                             uint16_t          aOperation,
+                             const uint8_t    *aValue,
+                             uint16_t          aValueLength,
+                             uint16_t          aFlags,
+                             uint64_t          aHash,
+                             const RecordList &aRemoved)
+{
+    EntryHeader  header = {aKey, aValueLength, aOperation, aFlags, (aOperation == kOpDelete) ? 0 : mNextRecordId, 0};
+    struct iovec iov[2] = {{&header, sizeof(header)}, {const_cast<uint8_t *>(aValue), aValueLength}};
+    off_t        length = kEntryHeaderSize + aValueLength;
+
+    if (aFlags & kFlagShared)
+    {
+        auto blob = mBlobs.find(aHash);
+
+        if (blob == mBlobs.end() || blob->second.mOffset == kNotInFile)
+        {
+            // The first link to a value is preceded by its blob.
+            EntryHeader  blobHeader = {0, static_cast<uint16_t>(kHashSize + aValueLength), kOpBlob,
+                                       static_cast<uint16_t>(aFlags & ~kFlagShared), 0, 0};
+            struct iovec blobIov[3] = {
+                {&blobHeader, sizeof(blobHeader)}, {&aHash, kHashSize}, {const_cast<uint8_t *>(aValue), aValueLength}};
+            off_t blobLength = kEntryHeaderSize + blobHeader.mLength;
+
+            blobHeader.mCrc = GetEntryCrc(blobHeader, aHash, aValue);
+            VerifyOrDie(pwritev(mSettingsFd, blobIov, 3, mLogSize) == blobLength, TY_EXIT_ERROR_ERRNO);
+            SETTINGS_FILE_COUNT(mBytesWritten, static_cast<uint64_t>(blobLength));
+            RegisterBlob(aHash, blobHeader, aValue, mLogSize + kEntryHeaderSize + kHashSize);
+            mLogSize += blobLength;
+        }
+
+        header.mFlags   = kFlagShared;
+        header.mLength  = kHashSize;
+        iov[1].iov_base = &aHash;
+        iov[1].iov_len  = kHashSize;
+        length          = kEntryHeaderSize + kHashSize;
+        aValue          = reinterpret_cast<const uint8_t *>(&aHash);
+    }
+
+    header.mCrc = GetEntryCrc(header, aValue);
+
+    // The entry is synced by `Commit()`, after the lock is released.
+    VerifyOrDie(pwritev(mSettingsFd, iov, 2, mLogSize) == length, TY_EXIT_ERROR_ERRNO);
+    SETTINGS_FILE_COUNT(mBytesWritten, static_cast<uint64_t>(length));
+
+    if (aOperation == kOpDelete)
+    {
+        mLogDeadBytes += length;
+    }
+    else
+    {
+        InsertRecord(header, aValue, mLogSize + kEntryHeaderSize);
+    }
+
+    for (const Record &gone : aRemoved)
+    {
+        mLogDeadBytes += kEntryHeaderSize + (gone.IsShared() ? kHashSize : gone.mLength);
+    }
+
+    mLogSize += length;
+
+    if (IsLogCompactionDue())
+    {
+        mRewriteNeeded = true;
+    }
+
+#if TYSETTINGS_POSIX_CONFIG_MMAP_ENABLE
+    if (mLogSize > static_cast<off_t>(mMapSize))
+    {
+        Map();
+    }
+#endif
+}
+
+bool SettingsFile::IsLogCompactionDue(void) const
+{
+    return mLogSize >= TYSETTINGS_POSIX_CONFIG_LOG_COMPACT_MIN_SIZE &&
+           mLogDeadBytes * 100 >= mLogSize * TYSETTINGS_POSIX_CONFIG_LOG_COMPACT_RATIO;
+}
+
+#endif // TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+
+void SettingsFile::Rewrite(void)
+{
+    // Only the thread holding `mCommitLock` changes state while holding the lock shared, writers are excluded.
+    std::shared_lock<std::shared_mutex> readLock(mLock);
+    int                                 swapFd = SwapOpen();
+    off_t                               offset = 0;
+    uint64_t                            change = mChangeSeq;
+    OffsetMap                           offsets;
+    BlobOffsetMap                       blobOffsets;
+#if TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+    IndexEntryList index;
+    off_t          lastEntry = 0;
+#endif
+
+    // The changes of an active batch are not written before `CommitBatch()`.
+    const RecordIndex &records = mBatchActive ? mBatchBackup : mRecords;
+
+    // The entries of the legacy format lack most of the header.
+    const bool copyHeaders = (mFormat == kFormatCurrent);
+
+    {
+        FileHeader header = {kFileMagic, kFileVersion, 0};
+
+        SwapAppend(swapFd, &header, sizeof(header));
+        offset = sizeof(header);
+    }
+
+    // Entries which are adjacent in the current file are copied with a single run, headers included.
+    off_t runStart = 0;
+    off_t runEnd   = 0;
+
+    for (const auto &entry : records)
+    {
+        for (const Record &record : entry.second)
+        {
+            if (record.IsShared())
+            {
+                EntryHeader header = {record.mKey, kHashSize, kOpAdd, kFlagShared, record.mId, 0};
+                auto        written = blobOffsets.find(record.mHash);
+
+                SwapWrite(swapFd, runStart, static_cast<uint64_t>(runEnd - runStart));
+                runStart = runEnd = 0;
+
+                if (written == blobOffsets.end())
+                {
+                    // Each blob is written once, ahead of its first link.
+                    EntryHeader blobHeader = {0, static_cast<uint16_t>(kHashSize + record.mLength), kOpBlob,
+                                              static_cast<uint16_t>(record.mFlags & ~kFlagShared), 0, 0};
+
+                    if (!record.IsStaged() && copyHeaders)
+                    {
+                        SwapWrite(swapFd, record.mOffset - kHashSize - kEntryHeaderSize,
+                                  static_cast<uint64_t>(kEntryHeaderSize + blobHeader.mLength));
+                    }
+                    else
+                    {
+                        std::vector<uint8_t> buffer;
+                        const uint8_t       *value = GetStoredValue(record, buffer);
+
+                        VerifyOrDie(value != nullptr, TY_EXIT_ERROR_ERRNO);
+                        blobHeader.mCrc = GetEntryCrc(blobHeader, record.mHash, value);
+                        SwapAppend(swapFd, &blobHeader, sizeof(blobHeader));
+                        SwapAppend(swapFd, &record.mHash, kHashSize);
+                        SwapAppend(swapFd, value, record.mLength);
+                    }
+
+                    written = blobOffsets.emplace(record.mHash, offset + kEntryHeaderSize + kHashSize).first;
+                    offset += kEntryHeaderSize + blobHeader.mLength;
+                }
+
+                header.mCrc = GetEntryCrc(header, reinterpret_cast<const uint8_t *>(&record.mHash));
+                SwapAppend(swapFd, &header, sizeof(header));
+                SwapAppend(swapFd, &record.mHash, kHashSize);
+#if TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+                index.push_back({written->second, record.mHash, record.mKey, record.mLength, record.mFlags,
+                                 record.mValueLength, record.mId, 0});
+                lastEntry = offset;
+#endif
+                offset += kEntryHeaderSize + kHashSize;
+#if !TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+                offsets[record.mId] = written->second;
+#endif
+                continue;
+            }
+
+            if (!record.IsStaged() && copyHeaders && record.mOffset - kEntryHeaderSize == runEnd)
+            {
+                runEnd = record.mOffset + record.mLength;
+            }
+            else if (!record.IsStaged() && copyHeaders)
+            {
+                SwapWrite(swapFd, runStart, static_cast<uint64_t>(runEnd - runStart));
+                runStart = record.mOffset - kEntryHeaderSize;
+                runEnd   = record.mOffset + record.mLength;
+            }
+            else
+            {
+                EntryHeader          header = {record.mKey, record.mLength, kOpAdd, record.mFlags, record.mId, 0};
+                std::vector<uint8_t> converted;
+                const uint8_t       *value = record.mValue.data();
+
+                SwapWrite(swapFd, runStart, static_cast<uint64_t>(runEnd - runStart));
+                runStart = runEnd = 0;
+
+                if (!record.IsStaged())
+                {
+                    converted.resize(record.mLength);
+                    VerifyOrDie(pread(mSettingsFd, converted.data(), record.mLength, record.mOffset) == record.mLength,
+                                TY_EXIT_ERROR_ERRNO);
+                    value = converted.data();
+                }
+
+                header.mCrc = GetEntryCrc(header, value);
+                SwapAppend(swapFd, &header, sizeof(header));
+                SwapAppend(swapFd, value, record.mLength);
+            }
+
+#if TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+            index.push_back({offset + kEntryHeaderSize, 0, record.mKey, record.mLength, record.mFlags,
+                             record.mValueLength, record.mId, 0});
+            lastEntry = offset;
+#endif
+            offset += kEntryHeaderSize;
+#if !TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+            // In write-back mode all values stay resident, otherwise they are read from the new file.
+            offsets[record.mId] = offset;
+#endif
+            offset += record.mLength;
+        }
+    }
+
+    SwapWrite(swapFd, runStart, static_cast<uint64_t>(runEnd - runStart));
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    {
+        // Cleared, a trailer left at the same offset by an earlier generation must not commit the bank early.
+        BankTrailer trailer = {};
+
+        SwapAppend(swapFd, &trailer, sizeof(trailer));
+    }
+#endif
+    SwapFlush(swapFd);
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    VerifyOrDie(ftruncate(swapFd, offset + kBankTrailerSize) == 0, TY_EXIT_ERROR_ERRNO);
+#endif
+
+    // Changes staged from here on are written by the next commit.
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    mDirty      = false;
+    mDirtyBytes = 0;
+#endif
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    // The changes of an active batch stay staged, `CommitBatch()` writes them with another rewrite.
+    mRewriteNeeded = mBatchActive;
+    mRewriteActive = true;
+#endif
+
+    readLock.unlock();
+
+    // Neither readers nor writers wait for the sync.
+    TY_SETTINGS_TRACE(swap_fsync__start, offset);
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    CommitBank(swapFd, offset);
+#else
+    VerifyOrDie(0 == fsync(swapFd), TY_EXIT_ERROR_ERRNO);
+#endif
+    TY_SETTINGS_TRACE(swap_fsync__done, offset);
+    SETTINGS_FILE_COUNT(mBytesWritten, static_cast<uint64_t>(offset));
+    SETTINGS_FILE_COUNT(mCommits, 1);
+
+#if TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+    // The index is replaced first, an index of a settings file which did not replace the current one is ignored.
+    WriteIndex(swapFd, offset, lastEntry, index);
+#endif
+
+    {
+        std::lock_guard<std::shared_mutex> lock(mLock);
+
+        SwapPersist(swapFd);
+        mFormat = kFormatCurrent;
+        ApplyOffsets(mRecords, offsets);
+        ApplyOffsets(mBatchBackup, offsets);
+        ApplyBlobOffsets(mBlobs, blobOffsets);
+        ApplyBlobOffsets(mBatchBlobs, blobOffsets);
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+        mLogSize       = offset;
+        mLogDeadBytes  = 0;
+        mRewriteActive = false;
+#endif
+    }
+
+    mCommittedSeq = change;
+}
+
+void SettingsFile::ApplyOffsets(RecordIndex &aRecords, const OffsetMap &aOffsets)
+{
+    for (auto &entry : aRecords)
+    {
+        for (Record &record : entry.second)
+        {
+            auto written = aOffsets.find(record.mId);
+
+            if (written != aOffsets.end())
+            {
+                record.mOffset = written->second;
+                std::vector<uint8_t>().swap(record.mValue);
+            }
+
+            // Records still located in the replaced file would be dangling.
+            TY_ASSERT(record.IsStaged() || written != aOffsets.end());
+        }
+    }
+}
+
+void SettingsFile::ApplyBlobOffsets(BlobIndex &aBlobs, const BlobOffsetMap &aOffsets)
+{
+    for (auto blob = aBlobs.begin(); blob != aBlobs.end();)
+    {
+        auto written = aOffsets.find(blob->first);
+
+        blob->second.mOffset = (written != aOffsets.end()) ? written->second : kNotInFile;
+
+        // Blobs no record links to were not written.
+        if (blob->second.mRefs == 0)
+        {
+            blob = aBlobs.erase(blob);
+        }
+        else
+        {
+            ++blob;
+        }
+    }
+}
+
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+void SettingsFile::GetStats(tyPlatSettingsStats &aStats) const
+{
+    aStats.mBytesRead += mBytesRead.load(std::memory_order_relaxed);
+    aStats.mBytesWritten += mBytesWritten.load(std::memory_order_relaxed);
+    aStats.mCommits += mCommits.load(std::memory_order_relaxed);
+    aStats.mBytesRewritten += mBytesRewritten.load(std::memory_order_relaxed);
+}
+#endif
+
+void SettingsFile::GetSettingsFilePath(char aFileName[kMaxFilePathSize], bool aSwap)
+{
+    snprintf(aFileName, kMaxFilePathSize, TY_CONFIG_POSIX_SETTINGS_PATH "/%s.%s", mSettingFileBaseName,
+             (aSwap ? "Swap" : "data"));
+}
+
+#if TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+void SettingsFile::GetIndexFilePath(char aFileName[kMaxFilePathSize], bool aSwap)
+{
+    snprintf(aFileName, kMaxFilePathSize, TY_CONFIG_POSIX_SETTINGS_PATH "/%s.%s", mSettingFileBaseName,
+             (aSwap ? "indexSwap" : "index"));
+}
+
+off_t SettingsFile::LoadIndex(off_t aSize)
+{
+    off_t                start = 0;
+    char                 fileName[kMaxFilePathSize];
+    std::vector<uint8_t> buffer;
+    IndexHeader          header;
+    FileHeader           fileHeader;
+    EntryHeader          lastHeader;
+    struct stat          st;
+    int                  fd;
+    ssize_t              length;
+
+    GetIndexFilePath(fileName, false);
+    fd = open(fileName, O_RDONLY | O_CLOEXEC);
+    VerifyOrExit(fd != -1);
+
+    VerifyOrDie(fstat(fd, &st) == 0, TY_EXIT_ERROR_ERRNO);
+    buffer.resize(static_cast<size_t>(st.st_size));
+    length = read(fd, buffer.data(), buffer.size());
+    VerifyOrDie(close(fd) == 0, TY_EXIT_ERROR_ERRNO);
+    SETTINGS_FILE_COUNT(mBytesRead, static_cast<uint64_t>(st.st_size));
+
+    VerifyOrExit(length == st.st_size && buffer.size() >= sizeof(header));
+    memcpy(&header, buffer.data(), sizeof(header));
+    VerifyOrExit(header.mMagic == kIndexMagic && header.mVersion == kIndexVersion);
+    VerifyOrExit(buffer.size() - sizeof(header) == header.mCount * sizeof(IndexEntry));
+    VerifyOrExit(header.mCrc == Crc32c(Crc32c(0, &header, offsetof(IndexHeader, mCrc)), buffer.data() + sizeof(header),
+                                       buffer.size() - sizeof(header)));
+
+    // The index describes the settings file it was written with, as long as the entries it describes are unchanged.
+    VerifyOrDie(fstat(mSettingsFd, &st) == 0, TY_EXIT_ERROR_ERRNO);
+    VerifyOrExit(header.mDevice == static_cast<uint64_t>(st.st_dev) &&
+                 header.mInode == static_cast<uint64_t>(st.st_ino));
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    VerifyOrExit(header.mSize >= static_cast<int64_t>(sizeof(fileHeader)) && header.mSize <= aSize);
+#else
+    VerifyOrExit(header.mSize >= static_cast<int64_t>(sizeof(fileHeader)) && header.mSize == aSize);
+#endif
+    VerifyOrExit(pread(mSettingsFd, &fileHeader, sizeof(fileHeader), 0) == sizeof(fileHeader));
+    VerifyOrExit(fileHeader.mMagic == kFileMagic && fileHeader.mVersion == kFileVersion);
+
+    // A torn or corrupted tail is most likely, the last entry is checked like the full scan would.
+    if (header.mLastEntry != 0)
+    {
+        std::vector<uint8_t> value;
+
+        VerifyOrExit(header.mLastEntry >= static_cast<int64_t>(sizeof(fileHeader)));
+        VerifyOrExit(pread(mSettingsFd, &lastHeader, sizeof(lastHeader), header.mLastEntry) == sizeof(lastHeader));
+        VerifyOrExit(header.mLastEntry + kEntryHeaderSize + lastHeader.mLength == header.mSize);
+        value.resize(lastHeader.mLength);
+        VerifyOrExit(pread(mSettingsFd, value.data(), value.size(), header.mLastEntry + kEntryHeaderSize) ==
+                     lastHeader.mLength);
+        VerifyOrExit(lastHeader.mCrc == GetEntryCrc(lastHeader, value.data()));
+    }
+    else
+    {
+        VerifyOrExit(header.mSize == static_cast<int64_t>(sizeof(fileHeader)));
+    }
+
+    for (uint32_t i = 0; i < header.mCount; i++)
+    {
+        IndexEntry entry;
+        off_t      minOffset;
+
+        memcpy(&entry, buffer.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        minOffset = sizeof(fileHeader) + kEntryHeaderSize + ((entry.mFlags & kFlagShared) ? kHashSize : 0);
+        VerifyOrExit((entry.mFlags & ~(kFlagCompressed | kFlagShared)) == 0);
+        VerifyOrExit(entry.mOffset >= minOffset && entry.mOffset + entry.mLength <= header.mSize);
+        VerifyOrExit(!(entry.mFlags & kFlagCompressed) || entry.mLength >= TY_SETTINGS_COMPRESS_HEADER_SIZE);
+
+        // The values are only checked against the checksums of their entries once they are read.
+        Record record = {entry.mId,     entry.mKey, entry.mLength, entry.mFlags, entry.mValueLength,
+                         entry.mOffset, {},         entry.mHash,   false};
+
+        mNextRecordId = std::max(mNextRecordId, entry.mId + 1);
+
+        if (record.IsShared())
+        {
+            RetainBlob(record);
+            mBlobs.at(record.mHash).mOffset = record.mOffset;
+        }
+
+        mRecords[entry.mKey].push_back(std::move(record));
+    }
+
+    start   = header.mSize;
+    mFormat = kFormatCurrent;
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    mLogDeadBytes = 0;
+#endif
+
+exit:
+    if (start == 0)
+    {
+        mRecords.clear();
+        mBlobs.clear();
+    }
+
+    return start;
+}
+
+void SettingsFile::WriteIndex(int aFd, off_t aSize, off_t aLastEntry, const IndexEntryList &aEntries)
+{
+    char         swapFile[kMaxFilePathSize];
+    char         indexFile[kMaxFilePathSize];
+    IndexHeader  header = {kIndexMagic, kIndexVersion, 0, 0, 0, aSize, aLastEntry,
+                           static_cast<uint32_t>(aEntries.size()), 0};
+    size_t       entriesLength = aEntries.size() * sizeof(IndexEntry);
+    struct iovec iov[2] = {{&header, sizeof(header)}, {const_cast<IndexEntry *>(aEntries.data()), entriesLength}};
+    struct stat  st;
+    ssize_t      length;
+    int          fd;
+
+    VerifyOrDie(fstat(aFd, &st) == 0, TY_EXIT_ERROR_ERRNO);
+    header.mDevice = static_cast<uint64_t>(st.st_dev);
+    header.mInode  = static_cast<uint64_t>(st.st_ino);
+    header.mCrc    = Crc32c(Crc32c(0, &header, offsetof(IndexHeader, mCrc)), aEntries.data(), entriesLength);
+
+    GetIndexFilePath(swapFile, true);
+    GetIndexFilePath(indexFile, false);
+
+    // The index is a cache, it is not synced and a settings file without a valid index is read as a whole.
+    fd = open(swapFile, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    VerifyOrExit(fd != -1);
+    length = writev(fd, iov, 2);
+    VerifyOrDie(close(fd) == 0, TY_EXIT_ERROR_ERRNO);
+    SETTINGS_FILE_COUNT(mBytesWritten, static_cast<uint64_t>(length > 0 ? length : 0));
+
+    if (length == static_cast<ssize_t>(sizeof(header) + entriesLength))
+    {
+        VerifyOrDie(0 == rename(swapFile, indexFile), TY_EXIT_ERROR_ERRNO);
+    }
+    else
+    {
+        unlink(swapFile);
+    }
+
+exit:
+    return;
+}
+#endif // TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+bool SettingsFile::LoadBanks(void)
+{
+    int         fds[2] = {mSettingsFd, mBankFd};
+    BankTrailer trailers[2];
+    bool        valid[2];
+    bool        loaded = false;
+    int         latest;
+
+    for (int bank = 0; bank < 2; bank++)
+    {
+        valid[bank] = ReadBankTrailer(fds[bank], trailers[bank]);
+    }
+
+    latest = (valid[1] && (!valid[0] || trailers[1].mGeneration > trailers[0].mGeneration)) ? 1 : 0;
+
+    // The other bank is the rollback target if the latest one is not valid throughout.
+    for (int bank : {latest, 1 - latest})
+    {
+        if (!valid[bank])
+        {
+            continue;
+        }
+
+        mSettingsFd = fds[bank];
+        mBankFd     = fds[1 - bank];
+
+        if (LoadFile(trailers[bank].mSize) == trailers[bank].mSize)
+        {
+            mGeneration = trailers[bank].mGeneration;
+            loaded      = true;
+            break;
+        }
+
+        mRecords.clear();
+        mBlobs.clear();
+    }
+
+    if (!loaded)
+    {
+        mSettingsFd = fds[0];
+        mBankFd     = fds[1];
+        mGeneration = 0;
+    }
+
+    return loaded;
+}
+
+bool SettingsFile::ReadBankTrailer(int aFd, BankTrailer &aTrailer)
+{
+    off_t size  = lseek(aFd, 0, SEEK_END);
+    bool  valid = false;
+
+    VerifyOrDie(size >= 0, TY_EXIT_ERROR_ERRNO);
+    VerifyOrExit(size >= static_cast<off_t>(sizeof(FileHeader)) + kBankTrailerSize);
+    VerifyOrExit(pread(aFd, &aTrailer, sizeof(aTrailer), size - kBankTrailerSize) == kBankTrailerSize);
+    VerifyOrExit(aTrailer.mMagic == kBankMagic && aTrailer.mVersion == kBankVersion);
+    VerifyOrExit(aTrailer.mCrc == Crc32c(0, &aTrailer, offsetof(BankTrailer, mCrc)));
+    VerifyOrExit(aTrailer.mSize == size - kBankTrailerSize && aTrailer.mGeneration != 0);
+    valid = true;
+
+exit:
+    return valid;
+}
+
+void SettingsFile::CommitBank(int aFd, off_t aSize)
+{
+    BankTrailer trailer = {kBankMagic, kBankVersion, 0, mGeneration + 1, aSize, 0, 0};
+
+    trailer.mCrc = Crc32c(0, &trailer, offsetof(BankTrailer, mCrc));
+
+    // The trailer commits the bank, it is only written once everything in front of it is durable.
+    VerifyOrDie(0 == fdatasync(aFd), TY_EXIT_ERROR_ERRNO);
+    VerifyOrDie(pwrite(aFd, &trailer, sizeof(trailer), aSize) == kBankTrailerSize, TY_EXIT_ERROR_ERRNO);
+    VerifyOrDie(0 == fdatasync(aFd), TY_EXIT_ERROR_ERRNO);
+    SETTINGS_FILE_COUNT(mBytesWritten, sizeof(trailer));
+}
+
+void SettingsFile::PinBank(uint64_t aGeneration)
+{
+    std::lock_guard<std::mutex> pinLock(mBankPinLock);
+
+    mBankPins[aGeneration & 1]++;
+}
+
+void SettingsFile::UnpinBank(uint64_t aGeneration)
+{
+    {
+        std::lock_guard<std::mutex> pinLock(mBankPinLock);
+
+        mBankPins[aGeneration & 1]--;
+    }
+
+    mBankUnpinned.notify_all();
+}
+#endif // TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+
+int SettingsFile::SwapOpen(void)
+{
+    int fd;
+
+    TY_SETTINGS_TRACE(swap_open__start, 0);
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    // The inactive bank is overwritten in place, `Rewrite()` truncates it to its new size.
+    fd = mBankFd;
+    VerifyOrDie(lseek(fd, 0, SEEK_SET) == 0, TY_EXIT_ERROR_ERRNO);
+#else
+    {
+        char fileName[kMaxFilePathSize];
+
+        GetSettingsFilePath(fileName, true);
+        fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        VerifyOrDie(fd != -1, TY_EXIT_ERROR_ERRNO);
+        VerifyOrDie(!mSecure || fchmod(fd, 0600) == 0, TY_EXIT_ERROR_ERRNO);
+    }
+#endif
+    TY_SETTINGS_TRACE(swap_open__done, fd);
+
+    mSwapBuffer.resize(TYSETTINGS_POSIX_CONFIG_COPY_BUFFER_SIZE);
+    mSwapBufferLength = 0;
+
+    return fd;
+}
+
+void SettingsFile::SwapAppend(int aFd, const void *aData, size_t aLength)
+{
+    // The value of an empty staged record has no storage.
+    VerifyOrExit(aLength > 0);
+
+    if (mSwapBufferLength + aLength > mSwapBuffer.size())
+    {
+        SwapFlush(aFd);
+    }
+
+    if (aLength > mSwapBuffer.size())
+    {
+        VerifyOrDie(write(aFd, aData, aLength) == static_cast<ssize_t>(aLength), TY_EXIT_FAILURE);
+    }
+    else
+    {
+        memcpy(mSwapBuffer.data() + mSwapBufferLength, aData, aLength);
+        mSwapBufferLength += aLength;
+    }
+
+exit:
+    return;
+}
+
+void SettingsFile::SwapFlush(int aFd)
+{
+    VerifyOrDie(write(aFd, mSwapBuffer.data(), mSwapBufferLength) == static_cast<ssize_t>(mSwapBufferLength),
+                TY_EXIT_FAILURE);
+    mSwapBufferLength = 0;
+}
+
+void SettingsFile::SwapWrite(int aFd, off_t aOffset, uint64_t aLength)
+{
+    VerifyOrExit(aLength > 0);
+
+    SETTINGS_FILE_COUNT(mBytesRewritten, aLength);
+    TY_SETTINGS_TRACE(swap_write__start, aLength);
+
+    SwapFlush(aFd);
+
+#if TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+    if (mCloneSupported)
+    {
+        SwapClone(aFd, aOffset, aLength);
+    }
+
+    if (mCopyRangeSupported)
+    {
+        SwapCopyRange(aFd, aOffset, aLength);
+    }
+#endif
+
+    while (aLength > 0)
+    {
+        size_t  count = aLength >= mSwapBuffer.size() ? mSwapBuffer.size() : static_cast<size_t>(aLength);
+        ssize_t rval  = pread(mSettingsFd, mSwapBuffer.data(), count, aOffset);
+
+        VerifyOrDie(rval > 0, TY_EXIT_FAILURE);
+        count = static_cast<size_t>(rval);
+        rval  = write(aFd, mSwapBuffer.data(), count);
+        VerifyOrDie(rval == static_cast<ssize_t>(count), TY_EXIT_FAILURE);
+        aOffset += static_cast<off_t>(count);
+        aLength -= count;
+    }
+
+    TY_SETTINGS_TRACE(swap_write__done, aOffset);
+
+exit:
+    return;
+}
+
+#if TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+void SettingsFile::SwapClone(int aFd, off_t &aOffset, uint64_t &aLength)
+{
+    off_t                   dest = lseek(aFd, 0, SEEK_CUR);
+    struct stat             st;
+    struct file_clone_range range;
+
+    VerifyOrDie(dest >= 0 && fstat(aFd, &st) == 0, TY_EXIT_ERROR_ERRNO);
+
+    // Only whole blocks at the same position within a block can be shared by both files.
+    VerifyOrExit(st.st_blksize > 0 && aOffset % st.st_blksize == 0 && dest % st.st_blksize == 0);
+
+    range.src_fd      = mSettingsFd;
+    range.src_offset  = static_cast<uint64_t>(aOffset);
+    range.src_length  = aLength - aLength % static_cast<uint64_t>(st.st_blksize);
+    range.dest_offset = static_cast<uint64_t>(dest);
+    VerifyOrExit(range.src_length > 0);
+
+    if (ioctl(aFd, FICLONERANGE, &range) != 0)
+    {
+        // Other errors are specific to the range, e.g. a block size which differs from `st_blksize`.
+        if (errno == EOPNOTSUPP || errno == ENOTTY || errno == EXDEV || errno == ENOSYS)
+        {
+            mCloneSupported = false;
+        }
+
+        ExitNow();
+    }
+
+    dest += static_cast<off_t>(range.src_length);
+    VerifyOrDie(lseek(aFd, dest, SEEK_SET) == dest, TY_EXIT_ERROR_ERRNO);
+    aOffset += static_cast<off_t>(range.src_length);
+    aLength -= range.src_length;
+
+exit:
+    return;
+}
+
+void SettingsFile::SwapCopyRange(int aFd, off_t &aOffset, uint64_t &aLength)
+{
+    while (aLength > 0)
+    {
+        off64_t offset = aOffset;
+        ssize_t rval   = copy_file_range(mSettingsFd, &offset, aFd, nullptr, static_cast<size_t>(aLength), 0);
+
+        if (rval <= 0)
+        {
+            // Whatever is left is copied through the buffer, which also reports unexpected errors.
+            if (rval < 0 && (errno == ENOSYS || errno == EXDEV || errno == EOPNOTSUPP || errno == EINVAL))
+            {
+                mCopyRangeSupported = false;
+            }
+
+            ExitNow();
+        }
+
+        aOffset += rval;
+        aLength -= static_cast<uint64_t>(rval);
+    }
+
+exit:
+    return;
+}
+#endif // TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+
+tinyError SettingsFile::CopyRange(int aFromFd, off_t aOffset, off_t aLength, int aToFd)
+{
+    tinyError            error = TY_ERROR_NONE;
+    std::vector<uint8_t> buffer;
+
+#if TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+    // Shares the blocks of both files on file systems supporting reflinks.
+    while (aLength > 0)
+    {
+        off64_t offset = aOffset;
+        ssize_t rval   = copy_file_range(aFromFd, &offset, aToFd, nullptr, static_cast<size_t>(aLength), 0);
+
+        // Whatever is left is copied through the buffer, e.g. to a pipe or socket.
+        if (rval <= 0)
+        {
+            break;
+        }
+
+        aOffset += rval;
+        aLength -= rval;
+    }
+#endif
+
+    buffer.resize(TYSETTINGS_POSIX_CONFIG_COPY_BUFFER_SIZE);
+
+    while (aLength > 0)
+    {
+        size_t  count = aLength >= static_cast<off_t>(buffer.size()) ? buffer.size() : static_cast<size_t>(aLength);
+        ssize_t rval  = pread(aFromFd, buffer.data(), count, aOffset);
+
+        VerifyOrDie(rval > 0, TY_EXIT_FAILURE);
+        count = static_cast<size_t>(rval);
+
+        for (size_t written = 0; written < count;)
+        {
+            rval = write(aToFd, buffer.data() + written, count - written);
+            VerifyOrExit(rval > 0 || (rval == -1 && errno == EINTR), error = TY_ERROR_FAILED);
+            written += (rval > 0) ? static_cast<size_t>(rval) : 0;
+        }
+
+        aOffset += static_cast<off_t>(count);
+        aLength -= static_cast<off_t>(count);
+    }
+
+exit:
+    return error;
+}
+
+void SettingsFile::SwapPersist(int aFd)
+{
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    // The bank is committed already, the banks only swap their roles.
+    mBankFd     = mSettingsFd;
+    mSettingsFd = aFd;
+    mGeneration++;
+#else
+    char swapFile[kMaxFilePathSize];
+    char dataFile[kMaxFilePathSize];
+
+    GetSettingsFilePath(swapFile, true);
+    GetSettingsFilePath(dataFile, false);
+
+    VerifyOrDie(0 == close(mSettingsFd), TY_EXIT_ERROR_ERRNO);
+    TY_SETTINGS_TRACE(swap_rename__start, aFd);
+    VerifyOrDie(0 == rename(swapFile, dataFile), TY_EXIT_ERROR_ERRNO);
+    TY_SETTINGS_TRACE(swap_rename__done, aFd);
+
+    mSettingsFd = aFd;
+#endif
+    Map();
+}
+
+void SettingsFile::Map(void)
+{
+    Unmap();
+
+#if TYSETTINGS_POSIX_CONFIG_MMAP_ENABLE
+    {
+        off_t  size = lseek(mSettingsFd, 0, SEEK_END);
+        size_t length;
+        void  *map;
+
+        // An empty file cannot be mapped, there is nothing to read from it anyway.
+        VerifyOrExit(size > 0);
+
+        length = static_cast<size_t>(size);
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+        // Leave room for appends, pages past the end of the file become readable as the log grows.
+        length *= 2;
+#endif
+
+        map = mmap(nullptr, length, PROT_READ, MAP_SHARED, mSettingsFd, 0);
+
+        // Reads fall back to `pread()` if the file system does not support mapping the file.
+        VerifyOrExit(map != MAP_FAILED);
+
+        mMap     = static_cast<const uint8_t *>(map);
+        mMapSize = length;
+    }
+
+exit:
+#endif
+    return;
+}
+
+void SettingsFile::Unmap(void)
+{
+    VerifyOrExit(mMap != nullptr);
+    VerifyOrDie(0 == munmap(const_cast<uint8_t *>(mMap), mMapSize), TY_EXIT_ERROR_ERRNO);
+    mMap     = nullptr;
+    mMapSize = 0;
+
+exit:
+    return;
 }
 
 } // namespace Posix
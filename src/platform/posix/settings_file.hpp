@@ -4,16 +4,91 @@
 #ifndef TY_POSIX_PLATFORM_SETTINGS_FILE_HPP_
 #define TY_POSIX_PLATFORM_SETTINGS_FILE_HPP_
 
+#include <sys/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
 #include <ty/ty-core-config.h>
+#include <tysettings/platform/settings.h>
+
+#include "tysettings-config.h"
 
 namespace ty {
 namespace Posix {
 
+/**
+ * Implements the settings file.
+ *
+ * Except for `Init()` and `Deinit()`, all methods may be called from multiple threads concurrently. Reads run in
+ * parallel, writers which arrive while another thread persists the settings file are written by one common commit.
+ */
 class SettingsFile
 {
 public:
+    static const size_t kMaxFileBaseNameSize = 64; ///< The size of a base name including the null character.
+
+    /**
+     * The trailer at the end of a bank, see `TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE`.
+     *
+     * A bank is only valid if its trailer is, the trailer is written once everything in front of it is durable.
+     */
+    struct BankTrailer
+    {
+        uint32_t mMagic;
+        uint16_t mVersion;
+        uint16_t mReserved;
+        uint64_t mGeneration; ///< Incremented by each rewrite, the valid bank with the latest generation is active.
+        int64_t  mSize;       ///< The size of the settings file in front of the trailer.
+        uint32_t mCrc;        ///< The CRC-32C of the trailer up to this field.
+        uint32_t mReserved2;
+    };
+
+    static constexpr off_t kBankTrailerSize = sizeof(BankTrailer); ///< The size of the trailer of a bank.
+
     SettingsFile(void)
         : mSettingsFd(-1)
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        , mBankFd(-1)
+        , mGeneration(0)
+        , mBankPins{0, 0}
+#endif
+        , mFormat(kFormatCurrent)
+        , mMap(nullptr)
+        , mMapSize(0)
+        , mSwapBufferLength(0)
+#if TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+        , mCloneSupported(true)
+        , mCopyRangeSupported(true)
+#endif
+        , mSecure(false)
+        , mBatchActive(false)
+        , mNextRecordId(0)
+        , mChangeSeq(0)
+        , mCommittedSeq(0)
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+        , mDirty(false)
+        , mDirtyBytes(0)
+        , mDirtySince(0)
+        , mWriteBackHandler(nullptr)
+        , mWriteBackContext(nullptr)
+#endif
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+        , mLogSize(0)
+        , mLogDeadBytes(0)
+        , mRewriteNeeded(false)
+        , mRewriteActive(false)
+#endif
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+        , mBytesRead(0)
+        , mBytesWritten(0)
+        , mCommits(0)
+        , mBytesRewritten(0)
+#endif
     {
     }
 
@@ -21,11 +96,16 @@ public:
      * Performs the initialization for the settings file.
      *
      * @param[in]  aSettingsFileBaseName    A pointer to the base name of the settings file.
+     * @param[in]  aSecure                  Whether the settings file holds sensitive keys. Its files are then only
+     *                                      accessible by their owner and changes are written through in write-back
+     *                                      mode.
+     *
+     * Entries are validated by their checksum. Everything from the first invalid entry on, e.g. the remainder of a torn
+     * write, is dropped while all entries before it are kept.
      *
      * @retval TY_ERROR_NONE    The given settings file was initialized successfully.
-     * @retval TY_ERROR_PARSE   The key-value format could not be parsed (invalid format).
      */
-    tinyError Init(const char *aSettingsFileBaseName);
+    tinyError Init(const char *aSettingsFileBaseName, bool aSecure);
 
     /**
      * Performs the de-initialization for the settings file.
@@ -45,6 +125,63 @@ public:
      */
     tinyError Get(uint16_t aKey, int aIndex, uint8_t *aValue, uint16_t *aValueLength);
 
+    /**
+     * Gets several settings from the settings file under a single lock.
+     *
+     * The result of each request is written to its `mError`, if not `nullptr`.
+     *
+     * @param[in]  aRequests  An array of pointers to the requests.
+     * @param[in]  aCount     The number of requests.
+     *
+     * @retval TY_ERROR_NONE       All settings were found.
+     * @retval TY_ERROR_NOT_FOUND  At least one setting was not found.
+     * @retval TY_ERROR_PARSE      At least one setting could not be read.
+     */
+    tinyError GetMany(const tyPlatSettingsRequest *const *aRequests, size_t aCount);
+
+    /**
+     * Gets a pointer to a setting within the memory mapped settings file.
+     *
+     * The pointer remains valid until the next modification of the settings file, by any thread.
+     *
+     * @param[in]   aKey     The key associated with the requested setting.
+     * @param[in]   aIndex   The index of the specific item to get.
+     * @param[out]  aData    A pointer to where the pointer to the value should be written.
+     * @param[out]  aLength  A pointer to where the length of the value should be written.
+     *
+     * @retval TY_ERROR_NONE             The given setting was found.
+     * @retval TY_ERROR_NOT_FOUND        The given key or index was not found in the setting store.
+     * @retval TY_ERROR_NOT_IMPLEMENTED  The settings file is not memory mapped or the value is stored compressed.
+     */
+    tinyError GetView(uint16_t aKey, int aIndex, const uint8_t **aData, uint16_t *aLength);
+
+    /**
+     * Finds the smallest key with at least one value which is not less than a given key.
+     *
+     * @param[in]   aKey      The key to start at.
+     * @param[out]  aNextKey  A reference to where the key found should be written.
+     *
+     * @retval TY_ERROR_NONE       A key was found.
+     * @retval TY_ERROR_NOT_FOUND  There is no key with values from @p aKey on.
+     */
+    tinyError GetNextKey(uint16_t aKey, uint16_t &aNextKey);
+
+    /**
+     * Gets the setting at a position of the settings file or, once the values of its key are exhausted, the first
+     * value of the next key.
+     *
+     * @param[in,out]  aKey          The key of the position, set to the key of the setting found.
+     * @param[in,out]  aIndex        The index of the position, set to the index of the setting found.
+     * @param[in]      aNextKeys     TRUE to continue with the next key, FALSE to only get values of @p aKey.
+     * @param[out]     aValue        A pointer to where the value of the setting should be written.
+     * @param[in,out]  aValueLength  A pointer to the length of the value.
+     *
+     * @retval TY_ERROR_NONE       A setting was found and fetched successfully.
+     * @retval TY_ERROR_NOT_FOUND  There is no setting from the position on.
+     * @retval TY_ERROR_PARSE      The setting could not be read.
+     */
+    tinyError GetNext(uint16_t &aKey, int &aIndex, bool aNextKeys, uint8_t *aValue, uint16_t *aValueLength);
+
     /**
      * Sets a setting in the settings file.
      *
@@ -60,8 +197,10 @@ public:
      * @param[in]  aKey          The key associated with the requested setting.
      * @param[in]  aValue        A pointer to where the new value of the setting should be read from.
      * @param[in]  aValueLength  The length of the data pointed to by aValue.
+     *
+     * @returns The identifier of the record added, see `GetById()`.
      */
-    void Add(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength);
+    uint32_t Add(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength);
 
     /**
      * Removes a setting from the settings file.
@@ -75,28 +214,550 @@ public:
      */
     tinyError Delete(uint16_t aKey, int aIndex);
 
+    /**
+     * Gets a setting by the identifier of its record.
+     *
+     * Identifiers are stored with the entries of the records and stay valid when the settings file is initialized
+     * again. The identifier of a removed record may be reused once no entry of the settings file holds it anymore.
+     *
+     * @param[in]      aKey          The key associated with the requested setting.
+     * @param[in]      aId           The identifier returned by `Add()`.
+     * @param[out]     aValue        A pointer to where the value of the setting should be written.
+     * @param[in,out]  aValueLength  A pointer to the length of the value.
+     *
+     * @retval TY_ERROR_NONE       The given setting was found and fetched successfully.
+     * @retval TY_ERROR_NOT_FOUND  There is no record with the identifier @p aId for @p aKey.
+     * @retval TY_ERROR_PARSE      The setting could not be read.
+     */
+    tinyError GetById(uint16_t aKey, uint32_t aId, uint8_t *aValue, uint16_t *aValueLength);
+
+    /**
+     * Removes a setting by the identifier of its record.
+     *
+     * @param[in]  aKey  The key associated with the setting.
+     * @param[in]  aId   The identifier returned by `Add()`.
+     *
+     * @retval TY_ERROR_NONE       The given setting was found and removed successfully.
+     * @retval TY_ERROR_NOT_FOUND  There is no record with the identifier @p aId for @p aKey.
+     */
+    tinyError DeleteById(uint16_t aKey, uint32_t aId);
+
+    /**
+     * Sets a setting without writing it to the settings file.
+     *
+     * The setting is visible to `Get()` immediately, `Persist()` writes it to the settings file.
+     *
+     * @param[in]   aKey          The key associated with the requested setting.
+     * @param[in]   aValue        A pointer to where the new value of the setting should be read from.
+     * @param[in]   aValueLength  The length of the data pointed to by aValue.
+     * @param[out]  aChange       A reference to where the change to pass to `Persist()` should be written.
+     *
+     * @retval TY_ERROR_NONE           The setting was changed.
+     * @retval TY_ERROR_INVALID_STATE  A batch is active.
+     */
+    tinyError SetAsync(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength, uint64_t &aChange);
+
+    /**
+     * Adds a setting without writing it to the settings file, see `SetAsync()`.
+     *
+     * @param[in]   aKey          The key associated with the requested setting.
+     * @param[in]   aValue        A pointer to where the new value of the setting should be read from.
+     * @param[in]   aValueLength  The length of the data pointed to by aValue.
+     * @param[out]  aChange       A reference to where the change to pass to `Persist()` should be written.
+     *
+     * @retval TY_ERROR_NONE           The setting was added.
+     * @retval TY_ERROR_INVALID_STATE  A batch is active.
+     */
+    tinyError AddAsync(uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength, uint64_t &aChange);
+
+    /**
+     * Removes a setting without writing the removal to the settings file, see `SetAsync()`.
+     *
+     * @param[in]   aKey     The key associated with the requested setting.
+     * @param[in]   aIndex   The index of the value to be removed, -1 for all values of @p aKey.
+     * @param[out]  aChange  A reference to where the change to pass to `Persist()` should be written.
+     *
+     * @retval TY_ERROR_NONE           The given key and index was found and removed.
+     * @retval TY_ERROR_NOT_FOUND      The given key or index was not found in the setting store.
+     * @retval TY_ERROR_INVALID_STATE  A batch is active.
+     */
+    tinyError DeleteAsync(uint16_t aKey, int aIndex, uint64_t &aChange);
+
+    /**
+     * Writes all changes up to and including @p aChange to the settings file, also in write-back mode.
+     *
+     * Blocks until the changes are durable. Changes which are persisted already return immediately.
+     *
+     * @param[in]  aChange  The change returned by `SetAsync()`, `AddAsync()` or `DeleteAsync()`.
+     */
+    void Persist(uint64_t aChange);
+
     /**
      * Deletes all settings from the setting file.
      */
     void Wipe(void);
 
+    /**
+     * Writes all changes held back in write-back mode to the settings file.
+     *
+     * @retval TY_ERROR_NONE           All changes are written.
+     * @retval TY_ERROR_INVALID_STATE  A batch is active.
+     */
+    tinyError Flush(void);
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    /**
+     * Is called when a change is held back in write-back mode while no earlier change is.
+     *
+     * The handler is called with the lock of the settings file held and must not call into the settings file.
+     *
+     * @param[in]  aFile     The settings file holding back the change.
+     * @param[in]  aContext  The pointer passed to `SetWriteBackHandler()`.
+     */
+    typedef void (*WriteBackHandler)(SettingsFile &aFile, void *aContext);
+
+    /**
+     * Sets the function which arms the deadline of the changes held back in write-back mode.
+     *
+     * The handler is called at once if changes are already held back.
+     *
+     * @param[in]  aHandler  The function to call, `nullptr` to not be notified.
+     * @param[in]  aContext  A pointer passed to @p aHandler.
+     */
+    void SetWriteBackHandler(WriteBackHandler aHandler, void *aContext);
+
+    /**
+     * Writes the changes held back in write-back mode if their interval expired.
+     *
+     * Nothing is written while a batch is active, `CommitBatch()` writes the changes then.
+     */
+    void WriteBackIfDue(void);
+#endif
+
+    /**
+     * Starts a batch.
+     *
+     * Until the batch is committed or aborted, changes are only staged in memory and `Get()` returns the staged
+     * values.
+     *
+     * @retval TY_ERROR_NONE           The batch was started.
+     * @retval TY_ERROR_INVALID_STATE  A batch is already active.
+     */
+    tinyError BeginBatch(void);
+
+    /**
+     * Writes all changes staged by the active batch with a single rewrite of the settings file.
+     *
+     * @retval TY_ERROR_NONE           The batch was committed.
+     * @retval TY_ERROR_INVALID_STATE  No batch is active.
+     */
+    tinyError CommitBatch(void);
+
+    /**
+     * Discards all changes staged by the active batch.
+     *
+     * @retval TY_ERROR_NONE           The batch was aborted.
+     * @retval TY_ERROR_INVALID_STATE  No batch is active.
+     */
+    tinyError AbortBatch(void);
+
+    /**
+     * A settings file pinned by `PinImages()`, released by `CopyImage()`.
+     */
+    struct ImagePin
+    {
+        int   mFd;   ///< A duplicate of the descriptor of the pinned settings file.
+        off_t mSize; ///< The size of the image in the pinned settings file.
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+        uint64_t mGeneration; ///< The generation of the pinned bank.
+#endif
+    };
+
+    /**
+     * Pins consistent images of several settings files for `CopyImage()`.
+     *
+     * Changes held back in write-back mode are written first. The files are pinned at the same point in time, holding
+     * their locks in the given order only briefly. The images contain all changes persisted before, but not the
+     * changes of an active batch.
+     *
+     * @param[in]   aFiles  The settings files to pin.
+     * @param[in]   aCount  The number of settings files in @p aFiles.
+     * @param[out]  aPins   The pins of the settings files, one per settings file.
+     */
+    static void PinImages(SettingsFile *aFiles, unsigned aCount, ImagePin *aPins);
+
+    /**
+     * Writes a pinned image of the settings file to @p aFd, from its current position on, and releases the pin.
+     *
+     * Writers are not blocked while the image is copied. It is not synced.
+     *
+     * @param[in]  aPin         The pin of the settings file by `PinImages()`.
+     * @param[in]  aFd          The file descriptor to write the image to.
+     * @param[in]  aWithHeader  TRUE to write the file header, FALSE to only append the entries to an image.
+     *
+     * @retval TY_ERROR_NONE    The image was written.
+     * @retval TY_ERROR_FAILED  The image could not be written to @p aFd.
+     */
+    tinyError CopyImage(const ImagePin &aPin, int aFd, bool aWithHeader);
+
+    /**
+     * Loads an image written by `CopyImage()` into a settings file object which is not initialized.
+     *
+     * The object only serves reads afterwards and must be neither initialized nor de-initialized. All values are held
+     * in memory, @p aFd is not used nor closed once this method returns.
+     *
+     * @param[in]  aFd  The file descriptor to read the image from.
+     *
+     * @retval TY_ERROR_NONE   The image was loaded.
+     * @retval TY_ERROR_PARSE  The image could not be read or is not valid throughout.
+     */
+    tinyError LoadImage(int aFd);
+
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+    /**
+     * Adds the input/output counters of the settings file since `Init()` to @p aStats.
+     *
+     * @param[in,out]  aStats  The statistics to add the counters to.
+     */
+    void GetStats(tyPlatSettingsStats &aStats) const;
+#endif
+
 private:
+    /**
+     * A flag which may be set by readers holding the lock shared, copies take its current state.
+     */
+    class SharedFlag
+    {
+    public:
+        SharedFlag(bool aValue = false)
+            : mValue(aValue)
+        {
+        }
+        SharedFlag(const SharedFlag &aOther)
+            : mValue(aOther.Get())
+        {
+        }
+        SharedFlag &operator=(const SharedFlag &aOther)
+        {
+            mValue.store(aOther.Get(), std::memory_order_relaxed);
+            return *this;
+        }
+
+        bool Get(void) const { return mValue.load(std::memory_order_relaxed); }
+        void Set(void) const { mValue.store(true, std::memory_order_relaxed); }
+
+    private:
+        mutable std::atomic<bool> mValue;
+    };
+
+    /**
+     * Describes the location of a single record in the settings file.
+     */
+    struct Record
+    {
+        bool IsStaged(void) const { return mOffset == kNotInFile; }
+        bool IsCompressed(void) const { return (mFlags & kFlagCompressed) != 0; }
+        bool IsShared(void) const { return (mFlags & kFlagShared) != 0; }
+
+        uint32_t             mId;          ///< Identifies the record, copies of a record share the identifier.
+        uint16_t             mKey;         ///< The key of the record.
+        uint16_t             mLength;      ///< The length of the value as stored.
+        uint16_t             mFlags;       ///< The flags of the entry of the record.
+        uint16_t             mValueLength; ///< The length of the value, differs from `mLength` if compressed.
+        off_t                mOffset;      ///< The offset of the value within the settings file, or `kNotInFile`.
+        std::vector<uint8_t> mValue;       ///< The value of a staged record which is not written to the file yet.
+        uint64_t             mHash;        ///< The hash of the value of a shared record, its blob.
+        SharedFlag           mVerified;    ///< The entry was checked against its checksum, records loaded from an index
+                                           ///< are checked when first read.
+    };
+
+    /**
+     * Describes a value shared by records, a shared record is located at the value of its blob.
+     */
+    struct Blob
+    {
+        off_t    mOffset;      ///< The offset of the value within the settings file, or `kNotInFile`.
+        uint16_t mLength;      ///< The length of the value as stored.
+        uint16_t mFlags;       ///< The flags of the value, without `kFlagShared`.
+        uint16_t mValueLength; ///< The length of the value, differs from `mLength` if compressed.
+        uint32_t mRefs;        ///< The number of records linking to the blob.
+        uint16_t mKey;         ///< The key of a record linking to the blob.
+        uint32_t mId;          ///< The identifier of a record linking to the blob, or `kNoRecordId` if unknown.
+    };
+
+    typedef std::vector<Record>            RecordList;
+    typedef std::map<uint16_t, RecordList> RecordIndex; ///< The records of each key, in file order.
+    typedef std::unordered_map<uint32_t, off_t> OffsetMap;     ///< The new offset of each record written by a rewrite.
+    typedef std::unordered_map<uint64_t, Blob>  BlobIndex;     ///< The blobs by the hash of their value.
+    typedef std::unordered_map<uint64_t, off_t> BlobOffsetMap; ///< The new offset of each blob written by a rewrite.
+
     static const size_t kMaxFileDirectorySize   = sizeof(TY_CONFIG_POSIX_SETTINGS_PATH);
     static const size_t kSlashLength            = 1;
-    static const size_t kMaxFileBaseNameSize    = 64;
-    static const size_t kMaxFileExtensionLength = 5; ///< The length of `.Swap` or `.data`.
+    static const size_t kMaxFileExtensionLength = 10; ///< The length of `.indexSwap`, the longest extension.
     static const size_t kMaxFilePathSize =
         kMaxFileDirectorySize + kSlashLength + kMaxFileBaseNameSize + kMaxFileExtensionLength;
 
-    tinyError Delete(uint16_t aKey, int aIndex, int *aSwapFd);
+    static constexpr off_t    kNotInFile  = -1;
+    static constexpr uint32_t kNoRecordId = UINT32_MAX;
+    static constexpr uint16_t kHashSize   = sizeof(uint64_t); ///< The value of a link is the hash of its blob.
+
+    /**
+     * The header at the beginning of a settings file.
+     */
+    struct FileHeader
+    {
+        uint32_t mMagic;
+        uint16_t mVersion;
+        uint16_t mReserved;
+    };
+
+    /**
+     * The header in front of the value of each entry of a settings file.
+     */
+    struct EntryHeader
+    {
+        uint16_t mKey;
+        uint16_t mLength;
+        uint16_t mOperation;
+        uint16_t mFlags;
+        uint32_t mId;  ///< The identifier of the record added by the entry, 0 for tombstones and blobs.
+        uint32_t mCrc; ///< The CRC32C of the preceding fields and the value.
+    };
+
+    /**
+     * A value as it is stored, compressed if it has at least `TYSETTINGS_CONFIG_COMPRESS_THRESHOLD` bytes and that
+     * makes it smaller, and shared if it has at least `TYSETTINGS_POSIX_CONFIG_DEDUP_MIN_LENGTH` bytes.
+     */
+    class StoredValue
+    {
+    public:
+        StoredValue(const uint8_t *aValue, uint16_t aLength);
+
+        const uint8_t *GetData(void) const { return mData; }
+        uint16_t       GetLength(void) const { return mLength; }
+        uint16_t       GetFlags(void) const { return mFlags; }
+        uint64_t       GetHash(void) const { return mHash; }
+
+    private:
+        const uint8_t       *mData;
+        uint16_t             mLength;
+        uint16_t             mFlags;
+        uint64_t             mHash;
+        std::vector<uint8_t> mCompressed;
+    };
+
+    /**
+     * The header of an index file, followed by an `IndexEntry` for each record of the settings file it describes.
+     *
+     * An index file is a cache written along with each rewrite of the settings file, it is ignored unless it matches
+     * the settings file.
+     */
+    struct IndexHeader
+    {
+        uint32_t mMagic;
+        uint16_t mVersion;
+        uint16_t mReserved;
+        uint64_t mDevice;    ///< The device of the settings file.
+        uint64_t mInode;     ///< The inode of the settings file.
+        int64_t  mSize;      ///< The size of the settings file, entries appended to the log later are read from it.
+        int64_t  mLastEntry; ///< The offset of the last entry, which is checked on load, or 0 if there is none.
+        uint32_t mCount;     ///< The number of entries.
+        uint32_t mCrc;       ///< The CRC-32C of the header up to this field and of the entries.
+    };
+
+    /**
+     * Describes a record in an index file, in the order of the settings file.
+     */
+    struct IndexEntry
+    {
+        int64_t  mOffset; ///< The offset of the value, of the blob of a shared record.
+        uint64_t mHash;   ///< The hash of the blob of a shared record.
+        uint16_t mKey;
+        uint16_t mLength;
+        uint16_t mFlags;
+        uint16_t mValueLength;
+        uint32_t mId;
+        uint32_t mReserved;
+    };
+
+    typedef std::vector<IndexEntry> IndexEntryList;
+
+    /**
+     * Identifies the format of a settings file.
+     */
+    enum Format : uint8_t
+    {
+        kFormatLegacy,  ///< Key, length and value of each record without a file header, as written before version 1.
+        kFormatCurrent, ///< Version 1, entries with an `EntryHeader`.
+    };
+
+    static constexpr uint32_t kFileMagic        = 0x4c535954; ///< "TYSL" in little endian.
+    static constexpr uint16_t kFileVersion      = 1;
+    static constexpr uint32_t kIndexMagic       = 0x58535954; ///< "TYSX" in little endian.
+    static constexpr uint16_t kIndexVersion     = 1;
+    static constexpr uint32_t kBankMagic        = 0x42535954; ///< "TYSB" in little endian.
+    static constexpr uint16_t kBankVersion      = 1;
+    static constexpr off_t    kLegacyHeaderSize = 2 * sizeof(uint16_t); ///< Key and length.
+    static constexpr off_t    kEntryHeaderSize  = sizeof(EntryHeader);
+
+    enum : uint16_t
+    {
+        kOpAdd    = 0, ///< Adds the value to the key.
+        kOpSet    = 1, ///< Replaces all values of the key.
+        kOpDelete = 2, ///< Tombstone, the value is the `int32_t` index of the removed value or -1 for all.
+        kOpBlob   = 3, ///< A shared value, the value is the hash followed by the value. The key is unused.
+    };
+
+    enum : uint16_t
+    {
+        kFlagCompressed = 1 << 0, ///< The value is compressed, see `tysettings-compress.h`.
+        kFlagShared     = 1 << 1, ///< The entry links to a blob, its value is the hash of the blob.
+    };
+
+    void            Load(void);
+    off_t           LoadFile(off_t aSize);
+    off_t           LoadEntries(const uint8_t *aData, off_t aStart, off_t aEnd);
+    static uint32_t GetEntryCrc(const EntryHeader &aHeader, const uint8_t *aValue);
+    static uint32_t GetEntryCrc(const EntryHeader &aHeader, uint64_t aHash, const uint8_t *aValue);
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    bool CanLogAppend(void) const { return !mBatchActive && !mRewriteActive && !mRewriteNeeded; }
+    void LogAppend(uint16_t          aKey,
+                   uint16_t          aOperation,
+                   const uint8_t    *aValue,
+                   uint16_t          aValueLength,
+                   uint16_t          aFlags,
+                   uint64_t          aHash,
+                   const RecordList &aRemoved);
+    bool IsLogCompactionDue(void) const;
+#endif
+
+    Record    *FindRecord(uint16_t aKey, int aIndex);
+    int        FindIndex(uint16_t aKey, uint32_t aId) const;
+    tinyError ReadValue(uint16_t aKey, int aIndex, uint8_t *aValue, uint16_t *aValueLength);
+    tinyError ReadCompressed(const Record &aRecord, uint8_t *aValue, uint16_t aLength);
+    tinyError VerifyRecord(const Record &aRecord);
+    void      InsertRecord(const EntryHeader &aHeader, const uint8_t *aValue, off_t aOffset);
+    void      RemoveRecords(uint16_t aKey, int aIndex, RecordList &aRemoved);
+    void      StageRecord(uint16_t aKey, const StoredValue &aValue, uint16_t aFlags);
+    void      ApplySet(uint16_t aKey, const StoredValue &aValue);
+    void      ApplyAdd(uint16_t aKey, const StoredValue &aValue);
+    tinyError ApplyDelete(uint16_t aKey, int aIndex);
+    uint64_t  Change(size_t aChangedBytes);
+    void      Commit(uint64_t aChange);
+    void      Rewrite(void);
+    void      ApplyOffsets(RecordIndex &aRecords, const OffsetMap &aOffsets);
+
+    const uint8_t *GetStoredValue(const Record &aRecord, std::vector<uint8_t> &aBuffer);
+    uint16_t       ResolveFlags(const StoredValue &aValue);
+    const Record  *FindShared(uint64_t aHash, Blob &aBlob);
+    void           RegisterBlob(uint64_t aHash, const EntryHeader &aHeader, const uint8_t *aValue, off_t aOffset);
+    void           RetainBlob(const Record &aRecord);
+    void           ReleaseBlob(const Record &aRecord);
+    void           ApplyBlobOffsets(BlobIndex &aBlobs, const BlobOffsetMap &aOffsets);
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    bool            IsFlushDue(void) const;
+    static uint64_t GetNow(void);
+#endif
     void      GetSettingsFilePath(char aFileName[kMaxFilePathSize], bool aSwap);
+#if TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+    void  GetIndexFilePath(char aFileName[kMaxFilePathSize], bool aSwap);
+    off_t LoadIndex(off_t aSize);
+    void  WriteIndex(int aFd, off_t aSize, off_t aLastEntry, const IndexEntryList &aEntries);
+#endif
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    bool        LoadBanks(void);
+    static bool ReadBankTrailer(int aFd, BankTrailer &aTrailer);
+    void        CommitBank(int aFd, off_t aSize);
+    void        PinBank(uint64_t aGeneration);
+    void        UnpinBank(uint64_t aGeneration);
+#endif
     int       SwapOpen(void);
-    void      SwapWrite(int aFd, uint16_t aLength);
+    void      SwapAppend(int aFd, const void *aData, size_t aLength);
+    void      SwapFlush(int aFd);
+    void      SwapWrite(int aFd, off_t aOffset, uint64_t aLength);
+#if TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+    void SwapClone(int aFd, off_t &aOffset, uint64_t &aLength);
+    void SwapCopyRange(int aFd, off_t &aOffset, uint64_t &aLength);
+#endif
+    static tinyError CopyRange(int aFromFd, off_t aOffset, off_t aLength, int aToFd);
     void      SwapPersist(int aFd);
-    void      SwapDiscard(int aFd);
+    void      Map(void);
+    void      Unmap(void);
+
+    /**
+     * Protects the index, the file descriptor and the mapping. Readers share it, writers stage their changes while
+     * holding it exclusively.
+     */
+    std::shared_mutex mLock;
+
+    /**
+     * Serializes persisting the settings file. The thread holding it writes the changes of all writers which staged
+     * theirs in the meantime.
+     */
+    std::mutex mCommitLock;
+
+    char        mSettingFileBaseName[kMaxFileBaseNameSize];
+    int         mSettingsFd;
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+    int      mBankFd;     ///< The inactive bank, overwritten by the next rewrite.
+    uint64_t mGeneration; ///< The generation of the active bank, 0 if it has no valid trailer.
+
+    /**
+     * Protects `mBankPins`. A rewrite waits on `mBankUnpinned` until no snapshot copies the bank it overwrites.
+     */
+    std::mutex              mBankPinLock;
+    std::condition_variable mBankUnpinned;
+    unsigned                mBankPins[2]; ///< The snapshots copying the bank of each parity of the generation.
+#endif
+    Format      mFormat; ///< The format of the current settings file, older formats are converted by `Init()`.
+    RecordIndex mRecords;
+    BlobIndex   mBlobs; ///< The blobs of the shared records of `mRecords`.
+
+    const uint8_t *mMap; ///< Read-only mapping of the settings file, or `nullptr` if not mapped.
+    size_t         mMapSize;
+
+    std::vector<uint8_t> mSwapBuffer; ///< Buffers writes to the swap file, only used by the committing thread.
+    size_t               mSwapBufferLength;
+#if TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+    bool mCloneSupported;     ///< Cleared once the file system rejects `FICLONERANGE`.
+    bool mCopyRangeSupported; ///< Cleared once the kernel or file system rejects `copy_file_range()`.
+#endif
+
+    bool        mSecure; ///< See `Init()`.
+    bool        mBatchActive;
+    RecordIndex mBatchBackup; ///< The index before the active batch, restored by `AbortBatch()`.
+    BlobIndex   mBatchBlobs;  ///< The blobs of `mBatchBackup`.
+
+    uint32_t mNextRecordId;
+    uint64_t mChangeSeq;    ///< The sequence number of the latest change, protected by `mLock`.
+    uint64_t mCommittedSeq; ///< The sequence number of the latest persisted change, protected by `mCommitLock`.
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+    bool     mDirty;      ///< Whether there are changes which are not written to the settings file yet.
+    size_t   mDirtyBytes; ///< The amount of value bytes changed since the last write.
+    uint64_t mDirtySince; ///< The time in milliseconds of the first change since the last write.
+
+    WriteBackHandler mWriteBackHandler;
+    void            *mWriteBackContext;
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+    off_t mLogSize;       ///< The size of the log, new entries are appended here.
+    off_t mLogDeadBytes;  ///< The bytes taken by tombstones and by replaced or removed records.
+    bool  mRewriteNeeded; ///< Whether there are staged changes or the log needs compaction. Later changes are staged
+                          ///< as well, the index of a tombstone appended meanwhile would count staged records.
+    bool  mRewriteActive; ///< Whether a rewrite is in progress, changes are staged instead of appended meanwhile.
+#endif
 
-    char mSettingFileBaseName[kMaxFileBaseNameSize];
-    int  mSettingsFd;
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+    // Updated by readers and the committing thread concurrently.
+    std::atomic<uint64_t> mBytesRead;
+    std::atomic<uint64_t> mBytesWritten;
+    std::atomic<uint64_t> mCommits;
+    std::atomic<uint64_t> mBytesRewritten;
+#endif
 };
 
 } // namespace Posix
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file
+ *   This file implements the counting of settings operations.
+ */
+
+#include <time.h>
+
+#include <ty/common/code_utils.hpp>
+#include <ty/common/debug.hpp>
+#include <ty/exit_code.h>
+
+#include "settings_stats.hpp"
+
+namespace ty {
+namespace Posix {
+
+void SettingsStats::Count(tyPlatSettingsOperation aOperation, uint64_t aLatencyNs)
+{
+    Operation &operation = mOperations[aOperation];
+    unsigned   bucket    = 0;
+
+    // Bucket i holds latencies of [2^i, 2^(i+1)) ns, the last bucket everything above.
+    if (aLatencyNs >= 2)
+    {
+        bucket = 63 - static_cast<unsigned>(__builtin_clzll(aLatencyNs));
+    }
+
+    if (bucket >= TY_PLAT_SETTINGS_STATS_NUM_BUCKETS)
+    {
+        bucket = TY_PLAT_SETTINGS_STATS_NUM_BUCKETS - 1;
+    }
+
+    operation.mCount.fetch_add(1, std::memory_order_relaxed);
+    operation.mLatency[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void SettingsStats::Get(tyPlatSettingsStats &aStats) const
+{
+    for (unsigned i = 0; i < TY_PLAT_SETTINGS_NUM_OPERATIONS; i++)
+    {
+        aStats.mOperations[i].mCount = mOperations[i].mCount.load(std::memory_order_relaxed);
+
+        for (unsigned bucket = 0; bucket < TY_PLAT_SETTINGS_STATS_NUM_BUCKETS; bucket++)
+        {
+            aStats.mOperations[i].mLatency[bucket] = mOperations[i].mLatency[bucket].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void SettingsStats::Reset(void)
+{
+    for (Operation &operation : mOperations)
+    {
+        operation.mCount.store(0, std::memory_order_relaxed);
+
+        for (std::atomic<uint64_t> &count : operation.mLatency)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t SettingsStats::GetNowNs(void)
+{
+    struct timespec now;
+
+    VerifyOrDie(0 == clock_gettime(CLOCK_MONOTONIC, &now), TY_EXIT_ERROR_ERRNO);
+
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+}
+
+} // namespace Posix
+} // namespace ty
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef TY_POSIX_PLATFORM_SETTINGS_STATS_HPP_
+#define TY_POSIX_PLATFORM_SETTINGS_STATS_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <tysettings/platform/settings.h>
+
+namespace ty {
+namespace Posix {
+
+/**
+ * Counts the calls of the settings operations and their latency.
+ *
+ * All counters are updated without locks, operations of several threads may be measured at the same time.
+ */
+class SettingsStats
+{
+public:
+    /**
+     * Measures a call of an operation from its construction to its destruction.
+     */
+    class Timer
+    {
+    public:
+        Timer(SettingsStats &aStats, tyPlatSettingsOperation aOperation)
+            : mStats(aStats)
+            , mOperation(aOperation)
+            , mStart(GetNowNs())
+        {
+        }
+
+        ~Timer(void) { mStats.Count(mOperation, GetNowNs() - mStart); }
+
+        Timer(const Timer &)            = delete;
+        Timer &operator=(const Timer &) = delete;
+
+    private:
+        SettingsStats          &mStats;
+        tyPlatSettingsOperation mOperation;
+        uint64_t                mStart;
+    };
+
+    /**
+     * Counts a call of an operation.
+     *
+     * @param[in]  aOperation  The operation called.
+     * @param[in]  aLatencyNs  The duration of the call in nanoseconds.
+     */
+    void Count(tyPlatSettingsOperation aOperation, uint64_t aLatencyNs);
+
+    /**
+     * Writes the operation counters to @p aStats, the other fields are left unchanged.
+     */
+    void Get(tyPlatSettingsStats &aStats) const;
+
+    /**
+     * Sets all counters to 0.
+     */
+    void Reset(void);
+
+    /**
+     * Returns the current time of the monotonic clock in nanoseconds.
+     */
+    static uint64_t GetNowNs(void);
+
+private:
+    struct Operation
+    {
+        std::atomic<uint64_t> mCount{0};
+        std::atomic<uint64_t> mLatency[TY_PLAT_SETTINGS_STATS_NUM_BUCKETS]{};
+    };
+
+    Operation mOperations[TY_PLAT_SETTINGS_NUM_OPERATIONS];
+};
+
+} // namespace Posix
+} // namespace ty
+
+#endif // TY_POSIX_PLATFORM_SETTINGS_STATS_HPP_
@@ -4,4 +4,217 @@
 #ifndef TYSETTINGS_POSIX_CONFIG_H_
 #define TYSETTINGS_POSIX_CONFIG_H_
 
-#endif // TYSETTINGS_ESP_CONFIG_H_
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_MMAP_ENABLE
+ *
+ * Define as 1 to serve reads from a read-only memory mapping of the settings file instead of `pread()`.
+ *
+ * Required by `tyPlatSettingsGetView()`.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_MMAP_ENABLE
+#define TYSETTINGS_POSIX_CONFIG_MMAP_ENABLE 1
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_COPY_BUFFER_SIZE
+ *
+ * The size in bytes of the buffer used to write the settings file when it is rewritten.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_COPY_BUFFER_SIZE
+#define TYSETTINGS_POSIX_CONFIG_COPY_BUFFER_SIZE (64 * 1024)
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+ *
+ * Define as 1 to let the kernel copy unchanged records when the settings file is rewritten, Linux only.
+ *
+ * Whole blocks are shared with the `FICLONERANGE` reflink where the file system supports it, the remainder is copied
+ * by `copy_file_range()`. Either falls back to copying through `TYSETTINGS_POSIX_CONFIG_COPY_BUFFER_SIZE` once the
+ * kernel or file system rejects it.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE
+#ifdef __linux__
+#define TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE 1
+#else
+#define TYSETTINGS_POSIX_CONFIG_KERNEL_COPY_ENABLE 0
+#endif
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+ *
+ * Define as 1 to store settings in an append-only log instead of rewriting the whole settings file on every write.
+ *
+ * Records and tombstones are appended to the end of the settings file and the file is compacted once the share of
+ * dead bytes exceeds `TYSETTINGS_POSIX_CONFIG_LOG_COMPACT_RATIO`. An existing settings file is converted on start-up.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+#define TYSETTINGS_POSIX_CONFIG_LOG_ENABLE 0
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_LOG_COMPACT_RATIO
+ *
+ * The share of dead bytes in the log, in percent, at which the log is compacted.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_LOG_COMPACT_RATIO
+#define TYSETTINGS_POSIX_CONFIG_LOG_COMPACT_RATIO 50
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_LOG_COMPACT_MIN_SIZE
+ *
+ * The size of the log, in bytes, below which it is never compacted.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_LOG_COMPACT_MIN_SIZE
+#define TYSETTINGS_POSIX_CONFIG_LOG_COMPACT_MIN_SIZE 4096
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+ *
+ * Define as 1 to hold the whole settings store in memory and write changes back to the settings file later.
+ *
+ * Changes are written once `TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL` milliseconds passed since the first pending
+ * change or `TYSETTINGS_POSIX_CONFIG_WRITE_BACK_MAX_DIRTY_BYTES` value bytes changed, whichever comes first. The
+ * amount is checked whenever a setting is changed. The interval is enforced by the helper thread of the asynchronous
+ * changes, which arms a deadline with the first pending change and writes the changes once it expires, also when no
+ * further setting is changed. `tyPlatSettingsFlush()` and `tyPlatSettingsDeinit()` write pending changes immediately. Changes which are
+ * not written yet are lost on a crash or power loss.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE
+#define TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE 0
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL
+ *
+ * The maximum age in milliseconds of pending changes in write-back mode, 0 to not limit the age.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL
+#define TYSETTINGS_POSIX_CONFIG_WRITE_BACK_INTERVAL 1000
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_WRITE_BACK_MAX_DIRTY_BYTES
+ *
+ * The maximum amount of changed value bytes pending in write-back mode, 0 to not limit the amount.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_WRITE_BACK_MAX_DIRTY_BYTES
+#define TYSETTINGS_POSIX_CONFIG_WRITE_BACK_MAX_DIRTY_BYTES 65536
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_MAX_INSTANCES
+ *
+ * The maximum number of instances with an initialized settings store at the same time. Each instance has its own
+ * settings file, see `tyPlatSettingsSetBaseName()`.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_MAX_INSTANCES
+#define TYSETTINGS_POSIX_CONFIG_MAX_INSTANCES 8
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_SHARDS
+ *
+ * The number of settings files the keys of an instance are distributed over, 1 to keep all keys in a single file.
+ *
+ * With more than one shard, the vendor-specific keys from `TY_SETTINGS_KEY_VENDOR_RESERVED_MIN` on are kept in the
+ * last shard and all other keys are distributed over the remaining shards by their key. Each shard is a settings file
+ * of its own, so a change only rewrites the file of its shard. The first shard keeps the file name of an unsharded
+ * store. Values found in another shard than their own, e.g. after enabling sharding, are moved on initialization.
+ *
+ * A batch is committed shard by shard, its changes are applied atomically within each shard only.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_SHARDS
+#define TYSETTINGS_POSIX_CONFIG_SHARDS 1
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_DEDUP_ENABLE
+ *
+ * Define as 1 to store identical values of at least `TYSETTINGS_POSIX_CONFIG_DEDUP_MIN_LENGTH` bytes only once per
+ * settings file.
+ *
+ * Such a value is written once as a blob, identified by its 64-bit hash, and every record of it links to the blob. A
+ * blob is dropped once no record links to it anymore. A value whose hash is taken by a different value is stored on
+ * its own. Settings files with shared values are read regardless of this option.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_DEDUP_ENABLE
+#define TYSETTINGS_POSIX_CONFIG_DEDUP_ENABLE 0
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_DEDUP_MIN_LENGTH
+ *
+ * The length in bytes from which on values are shared, as stored after compression. A link takes 20 bytes.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_DEDUP_MIN_LENGTH
+#define TYSETTINGS_POSIX_CONFIG_DEDUP_MIN_LENGTH 64
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+ *
+ * Define as 1 to write an index file next to the settings file, which lets `Init()` load the records without reading
+ * the settings file.
+ *
+ * The index is written whenever the settings file is rewritten and describes its records by offset. It is only used
+ * if it matches the settings file, whose last entry is checked on load, otherwise the settings file is read as a
+ * whole. Entries appended to the log since are read from the settings file. Values loaded from the index are checked
+ * against their checksum when first read, a mismatch fails the read like an input/output error.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+#define TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE 0
+#endif
+
+/**
+ * @def TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+ *
+ * Define as 1 to keep the settings file in two banks which are written alternately instead of replacing it by a
+ * rename on every rewrite.
+ *
+ * Bank A is the settings file, bank B the swap file of the single-bank layout. Each bank ends with a trailer holding
+ * its generation. A rewrite writes the inactive bank and syncs it, then commits it by writing and syncing its trailer
+ * with the next generation, without updating the directory. `Init()` picks the bank with the latest generation which
+ * is valid throughout, the other bank holds the previous state until the next rewrite. A settings file of the
+ * single-bank layout is taken over as bank A. Not compatible with `TYSETTINGS_POSIX_CONFIG_LOG_ENABLE`.
+ */
+#ifndef TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE
+#define TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE 0
+#endif
+
+/**
+ * @def TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
+ *
+ * Define as 1 to keep the sensitive keys passed to `tyPlatSettingsInit()` in a secure store apart from the shards.
+ *
+ * The secure store is a settings file of its own with the suffix `.s`, readable and writable by its owner only. Its
+ * changes are written through even in write-back mode, so that sensitive values are not lost with the process and
+ * writing them never rewrites the shards. Sensitive values are only returned when iterating their key and are not
+ * part of snapshots.
+ */
+#ifndef TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE
+#define TY_POSIX_CONFIG_SECURE_SETTINGS_ENABLE 0
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_SHARDS < 1 || TYSETTINGS_POSIX_CONFIG_SHARDS > 100
+#error "TYSETTINGS_POSIX_CONFIG_SHARDS must be between 1 and 100"
+#endif
+
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE && TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+#error "TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE and TYSETTINGS_POSIX_CONFIG_LOG_ENABLE are mutually exclusive"
+#endif
+
+// In write-back mode `Init()` reads all values into memory regardless.
+#if TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE && TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE
+#error "TYSETTINGS_POSIX_CONFIG_WRITE_BACK_ENABLE and TYSETTINGS_POSIX_CONFIG_INDEX_ENABLE are mutually exclusive"
+#endif
+
+// Appends to a bank would follow its trailer.
+#if TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE && TYSETTINGS_POSIX_CONFIG_LOG_ENABLE
+#error "TYSETTINGS_POSIX_CONFIG_DUALBANK_ENABLE and TYSETTINGS_POSIX_CONFIG_LOG_ENABLE are mutually exclusive"
+#endif
+
+#endif // TYSETTINGS_POSIX_CONFIG_H_
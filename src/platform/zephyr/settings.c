@@ -1,6 +1,9 @@
 // SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
 // SPDX-License-Identifier: Apache-2.0
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/random/random.h>
@@ -9,6 +12,11 @@
 #include <ty/error.h>
 #include <ty/instance.h>
 #include <ty/platform/toolchain.h>
+#include <tysettings/platform/settings.h>
+
+#include "tysettings-compress.h"
+#include "tysettings-config.h"
+#include "tysettings-trace.h"
 
 /* #include <ty/platform/settings.h> */
 #define CONFIG_TY_L2_LOG_LEVEL LOG_LEVEL_DBG
@@ -16,6 +24,55 @@ LOG_MODULE_REGISTER(net_tyPlat_settings, CONFIG_TY_L2_LOG_LEVEL);
 
 #define TY_SETTINGS_ROTY_KEY "tiny"
 #define TY_SETTINGS_MAX_PATH_LEN 32
+#define TY_SETTINGS_GET_MANY_BATCH 16
+
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+static tyPlatSettingsStats ty_settings_stats;
+static struct k_spinlock   ty_settings_stats_lock;
+
+struct ty_settings_timer
+{
+    tyPlatSettingsOperation operation;
+    uint32_t                start;
+};
+
+static void ty_settings_count(uint64_t *counter, uint64_t value)
+{
+    k_spinlock_key_t key = k_spin_lock(&ty_settings_stats_lock);
+
+    *counter += value;
+
+    k_spin_unlock(&ty_settings_stats_lock, key);
+}
+
+static void ty_settings_timer_stop(struct ty_settings_timer *timer)
+{
+    uint64_t                      latency = k_cyc_to_ns_floor64(k_cycle_get_32() - timer->start);
+    tyPlatSettingsOperationStats *stats   = &ty_settings_stats.mOperations[timer->operation];
+    unsigned int                  bucket  = 0;
+    k_spinlock_key_t              key;
+
+    /* Bucket i holds latencies of [2^i, 2^(i+1)) ns, the last bucket everything above. */
+    if (latency >= 2)
+    {
+        bucket = MIN(63 - __builtin_clzll(latency), TY_PLAT_SETTINGS_STATS_NUM_BUCKETS - 1);
+    }
+
+    key = k_spin_lock(&ty_settings_stats_lock);
+    stats->mCount++;
+    stats->mLatency[bucket]++;
+    k_spin_unlock(&ty_settings_stats_lock, key);
+}
+
+/* Measures the rest of the calling function as a call of the operation. */
+#define TY_SETTINGS_MEASURE(op)                                                                      \
+    struct ty_settings_timer ty_settings_timer __attribute__((cleanup(ty_settings_timer_stop))) = { \
+        .operation = (op), .start = k_cycle_get_32()}
+#define TY_SETTINGS_COUNT(counter, value) ty_settings_count(&ty_settings_stats.counter, (value))
+#else
+#define TY_SETTINGS_MEASURE(op)
+#define TY_SETTINGS_COUNT(counter, value)
+#endif
 
 struct ty_setting_delete_ctx
 {
@@ -70,6 +127,8 @@ static int ty_setting_delete_cb(const char *key, size_t len, settings_read_cb re
         __ASSERT_NO_MSG(false);
     }
 
+    TY_SETTINGS_COUNT(mCommits, 1);
+
     ctx->status = 0;
 
     if (ctx->target_index == ctx->index)
@@ -157,6 +216,98 @@ struct ty_setting_read_ctx
     int status;
 };
 
+/* Reads a setting of len bytes, length is the buffer size on input and the length of the value on output. */
+static int ty_setting_read_value(settings_read_cb read_cb, void *cb_arg, size_t len, uint8_t *value, uint16_t *length)
+{
+    int ret;
+#if TYSETTINGS_CONFIG_COMPRESS_THRESHOLD > 0
+    /* The whole setting is needed to decode an envelope, even for the length only. */
+    uint8_t *blob = k_malloc((len > 0) ? len : 1);
+
+    if (blob == NULL)
+    {
+        LOG_ERR("Failed to allocate %u bytes to read the setting", (unsigned int)len);
+        return -ENOMEM;
+    }
+
+    ret = (len > 0) ? read_cb(cb_arg, blob, len) : 0;
+    if ((ret != (int)len) || !tySettingsDecodeBlob(blob, len, value, length))
+    {
+        LOG_ERR("Failed to read the setting, ret: %d", ret);
+        k_free(blob);
+        return -EIO;
+    }
+
+    TY_SETTINGS_COUNT(mBytesRead, len);
+    k_free(blob);
+#else
+    if (value == NULL)
+    {
+        *length = len;
+        return 0;
+    }
+
+    if (*length < len)
+    {
+        len = *length;
+    }
+
+    ret = read_cb(cb_arg, value, len);
+    if (ret <= 0)
+    {
+        LOG_ERR("Failed to read the setting, ret: %d", ret);
+        return -EIO;
+    }
+
+    TY_SETTINGS_COUNT(mBytesRead, ret);
+    *length = len;
+#endif
+
+    return 0;
+}
+
+/* Saves a setting, values of at least TYSETTINGS_CONFIG_COMPRESS_THRESHOLD bytes are compressed into an envelope. */
+static int ty_setting_save(const char *path, uint16_t key, const uint8_t *value, uint16_t length)
+{
+    int ret;
+#if TYSETTINGS_CONFIG_COMPRESS_THRESHOLD > 0
+    size_t   blob_size = (size_t)length + TY_SETTINGS_ENVELOPE_HEADER_SIZE;
+    uint8_t *blob      = k_malloc(blob_size);
+    size_t   blob_length;
+
+    if (blob == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    blob_length = tySettingsEncodeBlob(value, length, blob, blob_size);
+
+    TY_SETTINGS_TRACE(settings_save__start, key);
+    ret = (blob_length != 0) ? settings_save_one(path, blob, blob_length) : settings_save_one(path, value, length);
+    TY_SETTINGS_TRACE(settings_save__done, key);
+
+    if (ret == 0)
+    {
+        TY_SETTINGS_COUNT(mBytesWritten, (blob_length != 0) ? blob_length : length);
+    }
+
+    k_free(blob);
+#else
+    ARG_UNUSED(key);
+
+    TY_SETTINGS_TRACE(settings_save__start, key);
+    ret = settings_save_one(path, value, length);
+    TY_SETTINGS_TRACE(settings_save__done, key);
+
+    if (ret == 0)
+    {
+        TY_SETTINGS_COUNT(mBytesWritten, length);
+    }
+#endif
+
+    return ret;
+}
+
 static int ty_setting_read_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg, void *param)
 {
     int                         ret;
@@ -174,37 +325,216 @@ static int ty_setting_read_cb(const char *key, size_t len, settings_read_cb read
 
     /* Found setting, break the loop. */
 
-    if ((ctx->value == NULL) || (ctx->length == NULL))
+    if (ctx->length != NULL)
+    {
+        ret = ty_setting_read_value(read_cb, cb_arg, len, ctx->value, ctx->length);
+        if (ret != 0)
+        {
+            ctx->status = -EIO;
+            return 1;
+        }
+    }
+
+    ctx->status = 0;
+
+    return 1;
+}
+
+struct ty_setting_read_many_ctx
+{
+    /* Requests resolved by this pass over the settings. */
+    const tyPlatSettingsRequest *requests;
+    size_t                       count;
+
+    /* Number of values of the key of each request passed so far. */
+    int index[TY_SETTINGS_GET_MANY_BATCH];
+
+    /* Operation result of each request. */
+    int status[TY_SETTINGS_GET_MANY_BATCH];
+};
+
+static int ty_setting_read_many_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg, void *param)
+{
+    int                              ret;
+    struct ty_setting_read_many_ctx *ctx = (struct ty_setting_read_many_ctx *)param;
+    unsigned long                    setting_key;
+    char                            *end;
+
+    if (key == NULL)
     {
-        goto out;
+        return 0;
     }
 
-    if (*(ctx->length) < len)
+    /* The key is the first path element, values added by tyPlatSettingsAdd() have a second one. */
+    setting_key = strtoul(key, &end, 16);
+    if ((end == key) || ((*end != '\0') && (*end != '/')))
     {
-        len = *(ctx->length);
+        return 0;
     }
 
-    ret = read_cb(cb_arg, ctx->value, len);
-    if (ret <= 0)
+    for (size_t i = 0; i < ctx->count; i++)
+    {
+        const tyPlatSettingsRequest *request = &ctx->requests[i];
+
+        if ((request->mKey != setting_key) || (ctx->index[i]++ != request->mIndex))
+        {
+            continue;
+        }
+
+        if (request->mValueLength != NULL)
+        {
+            ret = ty_setting_read_value(read_cb, cb_arg, len, request->mValue, request->mValueLength);
+            if (ret != 0)
+            {
+                ctx->status[i] = -EIO;
+                continue;
+            }
+        }
+
+        ctx->status[i] = 0;
+    }
+
+    /* Continue, further requests may match later settings. */
+    return 0;
+}
+
+struct ty_setting_iter_ctx
+{
+    /* Reads the value, target_index is the number of values of the subtree to pass first. */
+    struct ty_setting_read_ctx read;
+
+    /* Indicates if the subtree is the whole store, the key is then the first path element. */
+    bool whole_store;
+
+    /* Key of the value read. */
+    uint16_t key;
+};
+
+static int ty_setting_iter_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg, void *param)
+{
+    struct ty_setting_iter_ctx *ctx = (struct ty_setting_iter_ctx *)param;
+
+    if (ctx->whole_store && (key != NULL) && (ctx->read.target_index == ctx->read.index))
+    {
+        ctx->key = (uint16_t)strtoul(key, NULL, 16);
+    }
+
+    return ty_setting_read_cb(key, len, read_cb, cb_arg, &ctx->read);
+}
+
+/* Reads a whole setting of len bytes into a buffer allocated with k_malloc(), which the caller frees. */
+static int ty_setting_read_whole(settings_read_cb read_cb, void *cb_arg, size_t len, uint8_t **value, uint16_t *length)
+{
+    int      ret;
+    uint8_t *blob = k_malloc((len > 0) ? len : 1);
+
+    if (blob == NULL)
+    {
+        LOG_ERR("Failed to allocate %u bytes to read the setting", (unsigned int)len);
+        return -ENOMEM;
+    }
+
+    ret = (len > 0) ? read_cb(cb_arg, blob, len) : 0;
+    if ((ret != (int)len) || (len > UINT16_MAX))
     {
         LOG_ERR("Failed to read the setting, ret: %d", ret);
-        ctx->status = -EIO;
-        return 1;
+        k_free(blob);
+        return -EIO;
     }
 
-out:
-    if (ctx->length != NULL)
+    TY_SETTINGS_COUNT(mBytesRead, len);
+
+#if TYSETTINGS_CONFIG_COMPRESS_THRESHOLD > 0
+    /* The value is decoded from the blob read once, the settings backend may not read a setting twice. */
+    if (!tySettingsDecodeBlob(blob, len, NULL, length))
     {
-        *(ctx->length) = len;
+        LOG_ERR("Failed to decode the setting");
+        k_free(blob);
+        return -EIO;
     }
 
-    ctx->status = 0;
+    *value = k_malloc((*length > 0) ? *length : 1);
+    if (*value == NULL)
+    {
+        LOG_ERR("Failed to allocate %u bytes to decode the setting", (unsigned int)*length);
+        k_free(blob);
+        return -ENOMEM;
+    }
 
-    return 1;
+    if (!tySettingsDecodeBlob(blob, len, *value, length))
+    {
+        LOG_ERR("Failed to decode the setting");
+        k_free(*value);
+        k_free(blob);
+        return -EIO;
+    }
+
+    k_free(blob);
+#else
+    *value  = blob;
+    *length = (uint16_t)len;
+#endif
+
+    return 0;
+}
+
+struct ty_setting_for_each_ctx
+{
+    /* Function called for every value, with its instance and context. */
+    tyPlatSettingsForEachCallback callback;
+    tinyInstance                 *instance;
+    void                         *context;
+
+    /* Key of the subtree, -1 if the subtree is the whole store and the key is the first path element. */
+    int32_t key;
+
+    /* Operation result. */
+    int status;
+};
+
+static int ty_setting_for_each_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg, void *param)
+{
+    int                             ret;
+    struct ty_setting_for_each_ctx *ctx       = (struct ty_setting_for_each_ctx *)param;
+    uint16_t                        value_key = (uint16_t)ctx->key;
+    uint8_t                        *value;
+    uint16_t                        length;
+    bool                            more;
+
+    if (ctx->key == -1)
+    {
+        if (key == NULL)
+        {
+            /* The root of the store is not a setting. */
+            return 0;
+        }
+
+        value_key = (uint16_t)strtoul(key, NULL, 16);
+    }
+
+    ret = ty_setting_read_whole(read_cb, cb_arg, len, &value, &length);
+    if (ret != 0)
+    {
+        ctx->status = ret;
+        return 1;
+    }
+
+    more = ctx->callback(ctx->instance, value_key, value, length, ctx->context);
+    k_free(value);
+
+    return more ? 0 : 1;
 }
 
 /* Tiny APIs */
 
+tinyError tyPlatSettingsSetBaseName(tinyInstance *aInstance, const char *aBaseName)
+{
+    ARG_UNUSED(aInstance);
+    ARG_UNUSED(aBaseName);
+
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
 void tyPlatSettingsInit(tinyInstance *aInstance, const uint16_t *aSensitiveKeys, uint16_t aSensitiveKeysLength)
 {
     int ret;
@@ -218,6 +548,15 @@ void tyPlatSettingsInit(tinyInstance *aInstance, const uint16_t *aSensitiveKeys,
     {
         LOG_ERR("settings_subsys_init failed (ret %d)", ret);
     }
+
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+    {
+        k_spinlock_key_t key = k_spin_lock(&ty_settings_stats_lock);
+
+        memset(&ty_settings_stats, 0, sizeof(ty_settings_stats));
+        k_spin_unlock(&ty_settings_stats_lock, key);
+    }
+#endif
 }
 
 tinyError tyPlatSettingsGet(tinyInstance *aInstance, uint16_t aKey, int aIndex, uint8_t *aValue, uint16_t *aValueLength)
@@ -226,6 +565,7 @@ tinyError tyPlatSettingsGet(tinyInstance *aInstance, uint16_t aKey, int aIndex,
     char                       path[TY_SETTINGS_MAX_PATH_LEN];
     struct ty_setting_read_ctx read_ctx = {
         .value = aValue, .length = (uint16_t *)aValueLength, .status = -ENOENT, .target_index = aIndex};
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
 
     ARG_UNUSED(aInstance);
 
@@ -249,10 +589,199 @@ tinyError tyPlatSettingsGet(tinyInstance *aInstance, uint16_t aKey, int aIndex,
     return TY_ERROR_NONE;
 }
 
+tinyError tyPlatSettingsGetMany(tinyInstance *aInstance, const tyPlatSettingsRequest *aRequests, size_t aCount)
+{
+    int                             ret;
+    tinyError                       error = TY_ERROR_NONE;
+    struct ty_setting_read_many_ctx read_ctx;
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
+
+    ARG_UNUSED(aInstance);
+
+    LOG_DBG("%s Entry aCount %zu", __func__, aCount);
+
+    /* Every pass over the settings resolves up to TY_SETTINGS_GET_MANY_BATCH requests. */
+    for (size_t first = 0; first < aCount; first += read_ctx.count)
+    {
+        read_ctx.requests = &aRequests[first];
+        read_ctx.count    = MIN(aCount - first, TY_SETTINGS_GET_MANY_BATCH);
+
+        for (size_t i = 0; i < read_ctx.count; i++)
+        {
+            read_ctx.index[i]  = 0;
+            read_ctx.status[i] = -ENOENT;
+        }
+
+        ret = settings_load_subtree_direct(TY_SETTINGS_ROTY_KEY, ty_setting_read_many_cb, &read_ctx);
+        if (ret != 0)
+        {
+            LOG_ERR("Failed to load OT settings, ret %d", ret);
+        }
+
+        for (size_t i = 0; i < read_ctx.count; i++)
+        {
+            tinyError request_error = (read_ctx.status[i] == 0) ? TY_ERROR_NONE : TY_ERROR_NOT_FOUND;
+
+            if (read_ctx.requests[i].mError != NULL)
+            {
+                *(read_ctx.requests[i].mError) = request_error;
+            }
+
+            if (request_error != TY_ERROR_NONE)
+            {
+                error = request_error;
+            }
+        }
+    }
+
+    return error;
+}
+
+tinyError tyPlatSettingsIterBegin(tinyInstance *aInstance, tyPlatSettingsIter *aIter, int32_t aKey)
+{
+    ARG_UNUSED(aInstance);
+
+    if ((aKey < -1) || (aKey > UINT16_MAX))
+    {
+        return TY_ERROR_INVALID_ARGS;
+    }
+
+    aIter->mKey       = aKey;
+    aIter->mNextKey   = (aKey == -1) ? 0 : (uint16_t)aKey;
+    aIter->mNextIndex = 0;
+    aIter->mPosition  = 0;
+    aIter->mContext   = NULL;
+
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsIterNext(tinyInstance       *aInstance,
+                                 tyPlatSettingsIter *aIter,
+                                 uint16_t           *aKey,
+                                 uint8_t            *aValue,
+                                 uint16_t           *aValueLength)
+{
+    int                        ret;
+    char                       path[TY_SETTINGS_MAX_PATH_LEN];
+    struct ty_setting_iter_ctx iter_ctx = {.read        = {.value        = aValue,
+                                                           .length       = aValueLength,
+                                                           .status       = -ENOENT,
+                                                           .target_index = (int)aIter->mPosition},
+                                           .whole_store = (aIter->mKey == -1),
+                                           .key         = aIter->mNextKey};
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
+
+    ARG_UNUSED(aInstance);
+
+    LOG_DBG("%s Entry aKey %d position %u", __func__, aIter->mKey, aIter->mPosition);
+
+    /*
+     * The settings subsystem cannot resume a pass over the settings, the next pass stops right after the value at the
+     * position. The values passed before are only compared by name, not read.
+     */
+    if (aIter->mKey == -1)
+    {
+        ret = snprintk(path, sizeof(path), "%s", TY_SETTINGS_ROTY_KEY);
+    }
+    else
+    {
+        ret = snprintk(path, sizeof(path), "%s/%x", TY_SETTINGS_ROTY_KEY, aIter->mNextKey);
+    }
+    __ASSERT(ret < sizeof(path), "Setting path buffer too small.");
+
+    ret = settings_load_subtree_direct(path, ty_setting_iter_cb, &iter_ctx);
+    if (ret != 0)
+    {
+        LOG_ERR("Failed to load OT settings, ret %d", ret);
+    }
+
+    if (iter_ctx.read.status != 0)
+    {
+        return TY_ERROR_NOT_FOUND;
+    }
+
+    aIter->mPosition++;
+    aIter->mNextKey = iter_ctx.key;
+    aIter->mNextIndex++;
+
+    if (aKey != NULL)
+    {
+        *aKey = iter_ctx.key;
+    }
+
+    return TY_ERROR_NONE;
+}
+
+void tyPlatSettingsIterEnd(tinyInstance *aInstance, tyPlatSettingsIter *aIter)
+{
+    ARG_UNUSED(aInstance);
+    ARG_UNUSED(aIter);
+}
+
+tinyError tyPlatSettingsForEach(tinyInstance                 *aInstance,
+                                int32_t                       aKey,
+                                tyPlatSettingsForEachCallback aCallback,
+                                void                         *aContext)
+{
+    int                            ret;
+    char                           path[TY_SETTINGS_MAX_PATH_LEN];
+    struct ty_setting_for_each_ctx for_each_ctx = {
+        .callback = aCallback, .instance = aInstance, .context = aContext, .key = aKey, .status = 0};
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
+
+    LOG_DBG("%s Entry aKey %d", __func__, aKey);
+
+    if ((aKey < -1) || (aKey > UINT16_MAX))
+    {
+        return TY_ERROR_INVALID_ARGS;
+    }
+
+    /* A single pass over the subtree reads every value once, unlike the iteration which starts a pass per value. */
+    if (aKey == -1)
+    {
+        ret = snprintk(path, sizeof(path), "%s", TY_SETTINGS_ROTY_KEY);
+    }
+    else
+    {
+        ret = snprintk(path, sizeof(path), "%s/%x", TY_SETTINGS_ROTY_KEY, (uint16_t)aKey);
+    }
+    __ASSERT(ret < sizeof(path), "Setting path buffer too small.");
+
+    ret = settings_load_subtree_direct(path, ty_setting_for_each_cb, &for_each_ctx);
+    if (ret != 0)
+    {
+        LOG_ERR("Failed to load OT settings, ret %d", ret);
+    }
+
+    if (for_each_ctx.status == -ENOMEM)
+    {
+        return TY_ERROR_NO_BUFS;
+    }
+
+    return (for_each_ctx.status != 0) ? TY_ERROR_FAILED : TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsGetView(tinyInstance   *aInstance,
+                                uint16_t        aKey,
+                                int             aIndex,
+                                const uint8_t **aData,
+                                uint16_t       *aLength)
+{
+    ARG_UNUSED(aInstance);
+    ARG_UNUSED(aKey);
+    ARG_UNUSED(aIndex);
+    ARG_UNUSED(aData);
+    ARG_UNUSED(aLength);
+
+    /* Values are only accessible by copying them through the settings read callback. */
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
 tinyError tyPlatSettingsSet(tinyInstance *aInstance, uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
 {
     int  ret;
     char path[TY_SETTINGS_MAX_PATH_LEN];
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_SET);
 
     ARG_UNUSED(aInstance);
 
@@ -263,20 +792,33 @@ tinyError tyPlatSettingsSet(tinyInstance *aInstance, uint16_t aKey, const uint8_
     ret = snprintk(path, sizeof(path), "%s/%x", TY_SETTINGS_ROTY_KEY, aKey);
     __ASSERT(ret < sizeof(path), "Setting path buffer too small.");
 
-    ret = settings_save_one(path, aValue, aValueLength);
+    ret = ty_setting_save(path, aKey, aValue, aValueLength);
     if (ret != 0)
     {
         LOG_ERR("Failed to store setting %d, ret %d", aKey, ret);
         return TY_ERROR_NO_BUFS;
     }
 
+    TY_SETTINGS_COUNT(mCommits, 1);
+
     return TY_ERROR_NONE;
 }
 
 tinyError tyPlatSettingsAdd(tinyInstance *aInstance, uint16_t aKey, const uint8_t *aValue, uint16_t aValueLength)
 {
-    int  ret;
-    char path[TY_SETTINGS_MAX_PATH_LEN];
+    return tyPlatSettingsAddWithHandle(aInstance, aKey, aValue, aValueLength, NULL);
+}
+
+tinyError tyPlatSettingsAddWithHandle(tinyInstance         *aInstance,
+                                      uint16_t              aKey,
+                                      const uint8_t        *aValue,
+                                      uint16_t              aValueLength,
+                                      tyPlatSettingsHandle *aHandle)
+{
+    int      ret;
+    char     path[TY_SETTINGS_MAX_PATH_LEN];
+    uint32_t suffix;
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_ADD);
 
     ARG_UNUSED(aInstance);
 
@@ -284,23 +826,97 @@ tinyError tyPlatSettingsAdd(tinyInstance *aInstance, uint16_t aKey, const uint8_
 
     do
     {
-        ret = snprintk(path, sizeof(path), "%s/%x/%08x", TY_SETTINGS_ROTY_KEY, aKey, sys_rand32_get());
+        suffix = sys_rand32_get();
+        ret    = snprintk(path, sizeof(path), "%s/%x/%08x", TY_SETTINGS_ROTY_KEY, aKey, suffix);
         __ASSERT(ret < sizeof(path), "Setting path buffer too small.");
     } while (ty_setting_exists(path));
 
-    ret = settings_save_one(path, aValue, aValueLength);
+    ret = ty_setting_save(path, aKey, aValue, aValueLength);
     if (ret != 0)
     {
         LOG_ERR("Failed to store setting %d, ret %d", aKey, ret);
         return TY_ERROR_NO_BUFS;
     }
 
+    TY_SETTINGS_COUNT(mCommits, 1);
+
+    if (aHandle != NULL)
+    {
+        /* The handle holds both parts of the path of the setting. */
+        *aHandle = ((tyPlatSettingsHandle)aKey << 32) | suffix;
+    }
+
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsGetByHandle(tinyInstance        *aInstance,
+                                    tyPlatSettingsHandle aHandle,
+                                    uint8_t             *aValue,
+                                    uint16_t            *aValueLength)
+{
+    int                        ret;
+    char                       path[TY_SETTINGS_MAX_PATH_LEN];
+    struct ty_setting_read_ctx read_ctx = {
+        .value = aValue, .length = aValueLength, .status = -ENOENT, .target_index = 0};
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_GET);
+
+    ARG_UNUSED(aInstance);
+
+    LOG_DBG("%s Entry aHandle %llx", __func__, (unsigned long long)aHandle);
+
+    ret = snprintk(path, sizeof(path), "%s/%x/%08x", TY_SETTINGS_ROTY_KEY, (uint16_t)(aHandle >> 32),
+                   (uint32_t)aHandle);
+    __ASSERT(ret < sizeof(path), "Setting path buffer too small.");
+
+    ret = settings_load_subtree_direct(path, ty_setting_read_cb, &read_ctx);
+    if (ret != 0)
+    {
+        LOG_ERR("Failed to load OT setting %s, ret %d", path, ret);
+    }
+
+    if (read_ctx.status != 0)
+    {
+        return TY_ERROR_NOT_FOUND;
+    }
+
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsDeleteByHandle(tinyInstance *aInstance, tyPlatSettingsHandle aHandle)
+{
+    int  ret;
+    char path[TY_SETTINGS_MAX_PATH_LEN];
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_DELETE);
+
+    ARG_UNUSED(aInstance);
+
+    LOG_DBG("%s Entry aHandle %llx", __func__, (unsigned long long)aHandle);
+
+    ret = snprintk(path, sizeof(path), "%s/%x/%08x", TY_SETTINGS_ROTY_KEY, (uint16_t)(aHandle >> 32),
+                   (uint32_t)aHandle);
+    __ASSERT(ret < sizeof(path), "Setting path buffer too small.");
+
+    if (!ty_setting_exists(path))
+    {
+        return TY_ERROR_NOT_FOUND;
+    }
+
+    ret = settings_delete(path);
+    if (ret != 0)
+    {
+        LOG_ERR("Failed to delete setting %s, ret %d", path, ret);
+        return TY_ERROR_NOT_FOUND;
+    }
+
+    TY_SETTINGS_COUNT(mCommits, 1);
+
     return TY_ERROR_NONE;
 }
 
 tinyError tyPlatSettingsDelete(tinyInstance *aInstance, uint16_t aKey, int aIndex)
 {
     int ret;
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_DELETE);
 
     ARG_UNUSED(aInstance);
 
@@ -318,6 +934,8 @@ tinyError tyPlatSettingsDelete(tinyInstance *aInstance, uint16_t aKey, int aInde
 
 void tyPlatSettingsWipe(tinyInstance *aInstance)
 {
+    TY_SETTINGS_MEASURE(TY_PLAT_SETTINGS_OPERATION_WIPE);
+
     ARG_UNUSED(aInstance);
 
     (void)ty_setting_delete_subtree(-1, -1, true);
@@ -327,3 +945,128 @@ void tyPlatSettingsDeinit(tinyInstance *aInstance)
 {
     ARG_UNUSED(aInstance);
 }
+
+tinyError tyPlatSettingsFlush(tinyInstance *aInstance)
+{
+    ARG_UNUSED(aInstance);
+
+    /* settings_save_one() and settings_delete() write through, nothing is pending. */
+    return TY_ERROR_NONE;
+}
+
+tinyError tyPlatSettingsBeginBatch(tinyInstance *aInstance)
+{
+    ARG_UNUSED(aInstance);
+
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsCommitBatch(tinyInstance *aInstance)
+{
+    ARG_UNUSED(aInstance);
+
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsAbortBatch(tinyInstance *aInstance)
+{
+    ARG_UNUSED(aInstance);
+
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsSetAsync(tinyInstance          *aInstance,
+                                 uint16_t               aKey,
+                                 const uint8_t         *aValue,
+                                 uint16_t               aValueLength,
+                                 tyPlatSettingsCallback aCallback,
+                                 void                  *aContext)
+{
+    ARG_UNUSED(aInstance);
+    ARG_UNUSED(aKey);
+    ARG_UNUSED(aValue);
+    ARG_UNUSED(aValueLength);
+    ARG_UNUSED(aCallback);
+    ARG_UNUSED(aContext);
+
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsAddAsync(tinyInstance          *aInstance,
+                                 uint16_t               aKey,
+                                 const uint8_t         *aValue,
+                                 uint16_t               aValueLength,
+                                 tyPlatSettingsCallback aCallback,
+                                 void                  *aContext)
+{
+    ARG_UNUSED(aInstance);
+    ARG_UNUSED(aKey);
+    ARG_UNUSED(aValue);
+    ARG_UNUSED(aValueLength);
+    ARG_UNUSED(aCallback);
+    ARG_UNUSED(aContext);
+
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsDeleteAsync(tinyInstance          *aInstance,
+                                    uint16_t               aKey,
+                                    int                    aIndex,
+                                    tyPlatSettingsCallback aCallback,
+                                    void                  *aContext)
+{
+    ARG_UNUSED(aInstance);
+    ARG_UNUSED(aKey);
+    ARG_UNUSED(aIndex);
+    ARG_UNUSED(aCallback);
+    ARG_UNUSED(aContext);
+
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsGetStats(tinyInstance *aInstance, tyPlatSettingsStats *aStats)
+{
+    ARG_UNUSED(aInstance);
+
+#if TYSETTINGS_CONFIG_STATS_ENABLE
+    k_spinlock_key_t key = k_spin_lock(&ty_settings_stats_lock);
+
+    *aStats = ty_settings_stats;
+    k_spin_unlock(&ty_settings_stats_lock, key);
+
+    return TY_ERROR_NONE;
+#else
+    ARG_UNUSED(aStats);
+
+    return TY_ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+int tyPlatSettingsGetEventFd(tinyInstance *aInstance)
+{
+    ARG_UNUSED(aInstance);
+
+    return -1;
+}
+
+void tyPlatSettingsProcess(tinyInstance *aInstance)
+{
+    ARG_UNUSED(aInstance);
+}
+
+tinyError tyPlatSettingsSnapshot(tinyInstance *aInstance, int aFd)
+{
+    ARG_UNUSED(aInstance);
+    ARG_UNUSED(aFd);
+
+    /* The settings backends have no image which could be copied consistently. */
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
+
+tinyError tyPlatSettingsRestore(tinyInstance *aInstance, int aFd)
+{
+    ARG_UNUSED(aInstance);
+    ARG_UNUSED(aFd);
+
+    return TY_ERROR_NOT_IMPLEMENTED;
+}
@@ -6,4 +6,16 @@
 
 #include "autoconf.h"
 
+#ifdef CONFIG_TYSETTINGS_STATS
+#define TYSETTINGS_CONFIG_STATS_ENABLE 1
+#endif
+
+#ifdef CONFIG_TYSETTINGS_TRACE
+#define TYSETTINGS_CONFIG_TRACE_ENABLE 1
+#endif
+
+#ifdef CONFIG_TYSETTINGS_COMPRESS_THRESHOLD
+#define TYSETTINGS_CONFIG_COMPRESS_THRESHOLD CONFIG_TYSETTINGS_COMPRESS_THRESHOLD
+#endif
+
 #endif // TYSETTINGS_ZEPHYR_CONFIG_H_
@@ -0,0 +1,407 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file
+ *   This file implements the compression of large setting values.
+ *
+ * The compressor is a greedy LZ4 block compressor with a single hash table on the stack, it trades ratio for speed
+ * like LZ4 itself. The blocks follow the LZ4 block format and can be inspected with LZ4 tools.
+ */
+
+#include <string.h>
+
+#include "tysettings-compress.h"
+
+enum
+{
+    kMinMatch     = 4,  ///< The length of the shortest match.
+    kLastLiterals = 5,  ///< The number of bytes at the end of a block which are always literals.
+    kMatchLimit   = 12, ///< No match starts within this number of bytes before the end of a block.
+    kMaxNibble    = 15, ///< The largest length of a token nibble, longer lengths continue in further bytes.
+    kSkipTrigger  = 6,  ///< The search advances faster the longer no match was found, after 2^6 misses by 2 etc.
+};
+
+/**
+ * The magic prefix of an envelope, followed by `kEnvelopeCompressed` or `kEnvelopeRaw`.
+ */
+static const uint8_t kEnvelopeMagic[TY_SETTINGS_ENVELOPE_HEADER_SIZE - 1] = {0xf5, 'T', 'Z'};
+
+enum
+{
+    kEnvelopeCompressed = 'C', ///< The envelope holds a compressed value.
+    kEnvelopeRaw        = 'R', ///< The envelope holds a value which starts with the magic prefix itself.
+};
+
+static uint32_t read32(const uint8_t *aData)
+{
+    uint32_t value;
+
+    memcpy(&value, aData, sizeof(value));
+
+    return value;
+}
+
+static uint32_t hash32(uint32_t aValue)
+{
+    return (aValue * 2654435761u) >> (32 - TYSETTINGS_CONFIG_COMPRESS_HASH_LOG);
+}
+
+static bool writeLength(uint8_t **aOut, const uint8_t *aOutEnd, size_t aLength)
+{
+    for (; aLength >= 255; aLength -= 255)
+    {
+        if (*aOut >= aOutEnd)
+        {
+            return false;
+        }
+
+        *(*aOut)++ = 255;
+    }
+
+    if (*aOut >= aOutEnd)
+    {
+        return false;
+    }
+
+    *(*aOut)++ = (uint8_t)aLength;
+
+    return true;
+}
+
+/**
+ * Writes a sequence of literals followed by a match, the last sequence of a block has no match.
+ */
+static bool writeSequence(uint8_t      **aOut,
+                          const uint8_t *aOutEnd,
+                          const uint8_t *aLiterals,
+                          size_t         aLiteralLength,
+                          size_t         aOffset,
+                          size_t         aMatchLength)
+{
+    uint8_t *out = *aOut;
+    uint8_t *token;
+
+    if (out >= aOutEnd)
+    {
+        return false;
+    }
+
+    token  = out++;
+    *token = (uint8_t)((aLiteralLength >= kMaxNibble ? (size_t)kMaxNibble : aLiteralLength) << 4);
+
+    if (aLiteralLength >= kMaxNibble && !writeLength(&out, aOutEnd, aLiteralLength - kMaxNibble))
+    {
+        return false;
+    }
+
+    if ((size_t)(aOutEnd - out) < aLiteralLength)
+    {
+        return false;
+    }
+
+    memcpy(out, aLiterals, aLiteralLength);
+    out += aLiteralLength;
+
+    if (aMatchLength > 0)
+    {
+        size_t matchCode = aMatchLength - kMinMatch;
+
+        if (aOutEnd - out < 2)
+        {
+            return false;
+        }
+
+        *out++ = (uint8_t)(aOffset & 0xff);
+        *out++ = (uint8_t)(aOffset >> 8);
+        *token |= (uint8_t)(matchCode >= kMaxNibble ? (size_t)kMaxNibble : matchCode);
+
+        if (matchCode >= kMaxNibble && !writeLength(&out, aOutEnd, matchCode - kMaxNibble))
+        {
+            return false;
+        }
+    }
+
+    *aOut = out;
+
+    return true;
+}
+
+static bool readLength(const uint8_t **aIn, const uint8_t *aInEnd, size_t *aLength)
+{
+    uint8_t byte;
+
+    do
+    {
+        if (*aIn >= aInEnd)
+        {
+            return false;
+        }
+
+        byte = *(*aIn)++;
+        *aLength += byte;
+    } while (byte == 255);
+
+    return true;
+}
+
+size_t tySettingsCompress(const uint8_t *aValue, uint16_t aLength, uint8_t *aOut, size_t aOutSize)
+{
+    // Positions fit into 16 bits, values are at most 65535 bytes long.
+    uint16_t       table[1u << TYSETTINGS_CONFIG_COMPRESS_HASH_LOG];
+    const uint8_t *in     = aValue;
+    const uint8_t *anchor = aValue;
+    const uint8_t *end    = aValue + aLength;
+    uint8_t       *out    = aOut + TY_SETTINGS_COMPRESS_HEADER_SIZE;
+    uint8_t       *outEnd;
+
+    // Only compressed values which are smaller than the value are of use.
+    if (aOutSize >= aLength)
+    {
+        aOutSize = aLength > 0 ? aLength - 1u : 0;
+    }
+
+    if (aOutSize <= TY_SETTINGS_COMPRESS_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    outEnd  = aOut + aOutSize;
+    aOut[0] = (uint8_t)(aLength & 0xff);
+    aOut[1] = (uint8_t)(aLength >> 8);
+    memset(table, 0, sizeof(table));
+
+    if (aLength > kMatchLimit)
+    {
+        const uint8_t *matchStartLimit = end - kMatchLimit;
+        const uint8_t *matchEndLimit   = end - kLastLiterals;
+        unsigned       misses          = 0;
+
+        in++;
+
+        while (in <= matchStartLimit)
+        {
+            uint32_t       sequence  = read32(in);
+            uint32_t       hash      = hash32(sequence);
+            const uint8_t *candidate = aValue + table[hash];
+            const uint8_t *matchEnd;
+
+            table[hash] = (uint16_t)(in - aValue);
+
+            if (read32(candidate) != sequence)
+            {
+                in += 1 + (misses++ >> kSkipTrigger);
+                continue;
+            }
+
+            misses = 0;
+
+            while (in > anchor && candidate > aValue && in[-1] == candidate[-1])
+            {
+                in--;
+                candidate--;
+            }
+
+            matchEnd = in + kMinMatch;
+
+            while (matchEnd < matchEndLimit && *matchEnd == candidate[matchEnd - in])
+            {
+                matchEnd++;
+            }
+
+            if (!writeSequence(&out, outEnd, anchor, (size_t)(in - anchor), (size_t)(in - candidate),
+                               (size_t)(matchEnd - in)))
+            {
+                return 0;
+            }
+
+            in = anchor = matchEnd;
+        }
+    }
+
+    if (!writeSequence(&out, outEnd, anchor, (size_t)(end - anchor), 0, 0))
+    {
+        return 0;
+    }
+
+    return (size_t)(out - aOut);
+}
+
+uint16_t tySettingsGetDecompressedLength(const uint8_t *aCompressed)
+{
+    return (uint16_t)(aCompressed[0] | (aCompressed[1] << 8));
+}
+
+bool tySettingsDecompress(const uint8_t *aCompressed, size_t aCompressedLength, uint8_t *aValue, uint16_t aLength)
+{
+    const uint8_t *in    = aCompressed + TY_SETTINGS_COMPRESS_HEADER_SIZE;
+    const uint8_t *inEnd = aCompressed + aCompressedLength;
+    uint8_t       *out   = aValue;
+    uint8_t       *end   = aValue + aLength;
+
+    if (aCompressedLength < TY_SETTINGS_COMPRESS_HEADER_SIZE || aLength > tySettingsGetDecompressedLength(aCompressed))
+    {
+        return false;
+    }
+
+    // Decoding stops once the requested bytes are written, matches only refer to bytes written before.
+    while (out < end)
+    {
+        uint8_t token;
+        size_t  length;
+        size_t  offset;
+
+        if (in >= inEnd)
+        {
+            return false;
+        }
+
+        token  = *in++;
+        length = token >> 4;
+
+        if (length == kMaxNibble && !readLength(&in, inEnd, &length))
+        {
+            return false;
+        }
+
+        if ((size_t)(inEnd - in) < length)
+        {
+            return false;
+        }
+
+        memcpy(out, in, (size_t)(end - out) < length ? (size_t)(end - out) : length);
+        in += length;
+        out += (size_t)(end - out) < length ? (size_t)(end - out) : length;
+
+        if (out >= end)
+        {
+            break;
+        }
+
+        if (inEnd - in < 2)
+        {
+            return false;
+        }
+
+        offset = (size_t)(in[0] | (in[1] << 8));
+        in += 2;
+        length = (token & kMaxNibble) + kMinMatch;
+
+        if ((token & kMaxNibble) == kMaxNibble && !readLength(&in, inEnd, &length))
+        {
+            return false;
+        }
+
+        if (offset == 0 || offset > (size_t)(out - aValue))
+        {
+            return false;
+        }
+
+        if (length > (size_t)(end - out))
+        {
+            length = (size_t)(end - out);
+        }
+
+        if (offset >= length)
+        {
+            memcpy(out, out - offset, length);
+            out += length;
+        }
+        else
+        {
+            // The match overlaps the bytes it produces, they are copied byte by byte.
+            for (; length > 0; length--, out++)
+            {
+                *out = out[-(ptrdiff_t)offset];
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t tySettingsEncodeBlob(const uint8_t *aValue, uint16_t aLength, uint8_t *aBlob, size_t aBlobSize)
+{
+    size_t length = 0;
+
+#if TYSETTINGS_CONFIG_COMPRESS_THRESHOLD > 0
+    if (aLength >= TYSETTINGS_CONFIG_COMPRESS_THRESHOLD)
+    {
+        length = tySettingsCompress(aValue, aLength, aBlob + TY_SETTINGS_ENVELOPE_HEADER_SIZE,
+                                    aBlobSize - TY_SETTINGS_ENVELOPE_HEADER_SIZE);
+    }
+#else
+    (void)aBlobSize;
+#endif
+
+    if (length != 0)
+    {
+        aBlob[TY_SETTINGS_ENVELOPE_HEADER_SIZE - 1] = kEnvelopeCompressed;
+    }
+    else if (aLength >= sizeof(kEnvelopeMagic) && memcmp(aValue, kEnvelopeMagic, sizeof(kEnvelopeMagic)) == 0)
+    {
+        // Escapes a value which would otherwise be taken for an envelope.
+        memcpy(aBlob + TY_SETTINGS_ENVELOPE_HEADER_SIZE, aValue, aLength);
+        aBlob[TY_SETTINGS_ENVELOPE_HEADER_SIZE - 1] = kEnvelopeRaw;
+        length                                      = aLength;
+    }
+    else
+    {
+        return 0;
+    }
+
+    memcpy(aBlob, kEnvelopeMagic, sizeof(kEnvelopeMagic));
+
+    return TY_SETTINGS_ENVELOPE_HEADER_SIZE + length;
+}
+
+bool tySettingsDecodeBlob(const uint8_t *aBlob, size_t aBlobLength, uint8_t *aValue, uint16_t *aValueLength)
+{
+    const uint8_t *data   = aBlob + TY_SETTINGS_ENVELOPE_HEADER_SIZE;
+    size_t         length = aBlobLength - TY_SETTINGS_ENVELOPE_HEADER_SIZE;
+    uint16_t       valueLength;
+
+    if (aBlobLength < TY_SETTINGS_ENVELOPE_HEADER_SIZE || memcmp(aBlob, kEnvelopeMagic, sizeof(kEnvelopeMagic)) != 0)
+    {
+        // Values stored as is.
+        data   = aBlob;
+        length = aBlobLength;
+    }
+    else if (aBlob[TY_SETTINGS_ENVELOPE_HEADER_SIZE - 1] == kEnvelopeCompressed)
+    {
+        if (length < TY_SETTINGS_COMPRESS_HEADER_SIZE)
+        {
+            return false;
+        }
+
+        valueLength = tySettingsGetDecompressedLength(data);
+
+        if (aValue != NULL && !tySettingsDecompress(data, length, aValue,
+                                                    valueLength < *aValueLength ? valueLength : *aValueLength))
+        {
+            return false;
+        }
+
+        *aValueLength = valueLength;
+
+        return true;
+    }
+    else if (aBlob[TY_SETTINGS_ENVELOPE_HEADER_SIZE - 1] != kEnvelopeRaw)
+    {
+        return false;
+    }
+
+    if (length > UINT16_MAX)
+    {
+        return false;
+    }
+
+    if (aValue != NULL)
+    {
+        memcpy(aValue, data, length < *aValueLength ? length : *aValueLength);
+    }
+
+    *aValueLength = (uint16_t)length;
+
+    return true;
+}
@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file
+ *   This file declares the compression of large setting values, see `TYSETTINGS_CONFIG_COMPRESS_THRESHOLD`.
+ *
+ * A compressed value consists of the length of the value as 16-bit little endian followed by an LZ4 block. Backends
+ * whose records carry no flags store values in an envelope, which marks compressed values by a magic prefix.
+ */
+
+#ifndef TYSETTINGS_COMPRESS_H_
+#define TYSETTINGS_COMPRESS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tysettings-config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The size of the length in front of a compressed value.
+ */
+#define TY_SETTINGS_COMPRESS_HEADER_SIZE 2
+
+/**
+ * The size of the magic prefix of a value in an envelope.
+ */
+#define TY_SETTINGS_ENVELOPE_HEADER_SIZE 4
+
+/**
+ * Compresses a value.
+ *
+ * @param[in]   aValue    A pointer to the value.
+ * @param[in]   aLength   The length of the value.
+ * @param[out]  aOut      A pointer to where the compressed value should be written.
+ * @param[in]   aOutSize  The size of the buffer pointed to by @p aOut.
+ *
+ * @returns The length of the compressed value, or 0 if it would not be smaller than the value or @p aOutSize.
+ */
+size_t tySettingsCompress(const uint8_t *aValue, uint16_t aLength, uint8_t *aOut, size_t aOutSize);
+
+/**
+ * Gets the length of the value of a compressed value.
+ *
+ * @param[in]  aCompressed  A pointer to the compressed value, at least `TY_SETTINGS_COMPRESS_HEADER_SIZE` bytes.
+ *
+ * @returns The length of the value.
+ */
+uint16_t tySettingsGetDecompressedLength(const uint8_t *aCompressed);
+
+/**
+ * Decompresses the beginning of a compressed value.
+ *
+ * @param[in]   aCompressed        A pointer to the compressed value.
+ * @param[in]   aCompressedLength  The length of the compressed value.
+ * @param[out]  aValue             A pointer to where the value should be written.
+ * @param[in]   aLength            The number of bytes of the value to write, at most its length.
+ *
+ * @retval TRUE   The first @p aLength bytes of the value were written.
+ * @retval FALSE  The compressed value is not valid.
+ */
+bool tySettingsDecompress(const uint8_t *aCompressed, size_t aCompressedLength, uint8_t *aValue, uint16_t aLength);
+
+/**
+ * Encodes a value into an envelope, compressing it if it has at least `TYSETTINGS_CONFIG_COMPRESS_THRESHOLD` bytes.
+ *
+ * @param[in]   aValue     A pointer to the value.
+ * @param[in]   aLength    The length of the value.
+ * @param[out]  aBlob      A pointer to where the envelope should be written.
+ * @param[in]   aBlobSize  The size of the buffer pointed to by @p aBlob, at least `aLength +
+ *                         TY_SETTINGS_ENVELOPE_HEADER_SIZE`.
+ *
+ * @returns The length of the envelope, or 0 if the value is stored as is.
+ */
+size_t tySettingsEncodeBlob(const uint8_t *aValue, uint16_t aLength, uint8_t *aBlob, size_t aBlobSize);
+
+/**
+ * Decodes a value stored by a backend which uses envelopes.
+ *
+ * Values stored as is are returned unchanged.
+ *
+ * @param[in]      aBlob         A pointer to the stored value.
+ * @param[in]      aBlobLength   The length of the stored value.
+ * @param[out]     aValue        A pointer to where the value should be written. May be NULL.
+ * @param[in,out]  aValueLength  The size of the buffer pointed to by @p aValue, set to the length of the value.
+ *
+ * @retval TRUE   The value was decoded, truncated to the size of the buffer.
+ * @retval FALSE  The stored value is not valid.
+ */
+bool tySettingsDecodeBlob(const uint8_t *aBlob, size_t aBlobLength, uint8_t *aValue, uint16_t *aValueLength);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // TYSETTINGS_COMPRESS_H_
@@ -11,4 +11,49 @@
 #include TYSETTINGS_PLATFORM_CONFIG_FILE
 #endif
 
+/**
+ * @def TYSETTINGS_CONFIG_STATS_ENABLE
+ *
+ * Define as 1 to count the operations and input/output of the settings store, see `tyPlatSettingsGetStats()`.
+ *
+ * When defined as 0 the operations are not instrumented at all.
+ */
+#ifndef TYSETTINGS_CONFIG_STATS_ENABLE
+#define TYSETTINGS_CONFIG_STATS_ENABLE 0
+#endif
+
+/**
+ * @def TYSETTINGS_CONFIG_TRACE_ENABLE
+ *
+ * Define as 1 to emit trace probes around the expensive points of the persistence path, see `tysettings-trace.h`.
+ *
+ * On Linux this requires `<sys/sdt.h>`, e.g. from the `systemtap-sdt-dev` package.
+ */
+#ifndef TYSETTINGS_CONFIG_TRACE_ENABLE
+#define TYSETTINGS_CONFIG_TRACE_ENABLE 0
+#endif
+
+/**
+ * @def TYSETTINGS_CONFIG_COMPRESS_THRESHOLD
+ *
+ * The length in bytes from which on setting values are stored compressed, 0 to never compress values.
+ *
+ * Values are only stored compressed if that makes them smaller. Compressed and uncompressed values coexist, values
+ * stored before are read as they are.
+ */
+#ifndef TYSETTINGS_CONFIG_COMPRESS_THRESHOLD
+#define TYSETTINGS_CONFIG_COMPRESS_THRESHOLD 0
+#endif
+
+/**
+ * @def TYSETTINGS_CONFIG_COMPRESS_HASH_LOG
+ *
+ * The base 2 logarithm of the number of entries of the hash table used to compress a value.
+ *
+ * The table takes 2 bytes per entry on the stack, more entries find more matches.
+ */
+#ifndef TYSETTINGS_CONFIG_COMPRESS_HASH_LOG
+#define TYSETTINGS_CONFIG_COMPRESS_HASH_LOG 10
+#endif
+
 #endif // TYSETTINGS_CORE_CONFIG_H_
@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: Copyright 2025 Clever Design (Switzerland) GmbH
+// SPDX-License-Identifier: Apache-2.0
+#ifndef TYSETTINGS_TRACE_H_
+#define TYSETTINGS_TRACE_H_
+
+#include "tysettings-config.h"
+
+/**
+ * @def TY_SETTINGS_TRACE
+ *
+ * Marks an expensive point of the persistence path as @p aProbe with the numeric argument @p aArg.
+ *
+ * Probes come in pairs named `<point>__start` and `<point>__done`. On Linux they are USDT probes of the provider
+ * `tysettings`, e.g. `bpftrace -e 'usdt:./app:tysettings:swap_fsync__done { ... }'`. On Zephyr with `CONFIG_TRACING`
+ * they are named events of the tracing subsystem, elsewhere the application provides `tyPlatSettingsTrace()`.
+ *
+ * Expands to nothing unless `TYSETTINGS_CONFIG_TRACE_ENABLE` is set.
+ */
+#if !TYSETTINGS_CONFIG_TRACE_ENABLE
+#define TY_SETTINGS_TRACE(aProbe, aArg) \
+    do                                  \
+    {                                   \
+    } while (0)
+#elif defined(__linux__)
+#include <sys/sdt.h>
+#define TY_SETTINGS_TRACE(aProbe, aArg) DTRACE_PROBE1(tysettings, aProbe, aArg)
+#elif defined(__ZEPHYR__) && defined(CONFIG_TRACING)
+#include <zephyr/tracing/tracing.h>
+#define TY_SETTINGS_TRACE(aProbe, aArg) sys_trace_named_event("tysettings:" #aProbe, (uint32_t)(aArg), 0)
+#else
+#include <tysettings/platform/settings.h>
+#define TY_SETTINGS_TRACE(aProbe, aArg) tyPlatSettingsTrace("tysettings:" #aProbe, (uint64_t)(aArg))
+#endif
+
+#endif // TYSETTINGS_TRACE_H_